@@ -0,0 +1,472 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file BakedOctree.hpp
+ * @brief Memory-Mapped Octree Files Queried in Place.
+ *
+ * A baked file holds the nodes of an octree as an array linked by index,
+ * the bounds of its items in the lanes of a BoundaryBoxBlock and the items
+ * themselves, every section aligned so that it can be used straight from
+ * the mapping. The items are stored depth first, the items of a subtree
+ * are one contiguous range.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include "DynamicOctree.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+    ~MappedFile() { unmap(); }
+
+    /**
+     * @return false when the file cannot be opened or is empty.
+     */
+    [[nodiscard]] inline bool map(const std::filesystem::path &path) noexcept
+    {
+        unmap();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size{};
+        HANDLE mapping = nullptr;
+
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+
+        _data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        _size = _data ? static_cast<size_t>(size.QuadPart) : 0u;
+#else
+        const int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+
+        struct stat status{};
+        if (::fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void *data = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+
+            if (data != MAP_FAILED)
+            {
+                _data = data;
+                _size = static_cast<size_t>(status.st_size);
+            }
+        }
+        ::close(file);
+#endif
+
+        return _data != nullptr;
+    }
+
+    [[nodiscard]] inline const std::byte *data() const noexcept { return static_cast<const std::byte *>(_data); }
+    [[nodiscard]] inline size_t size() const noexcept { return _size; }
+
+private:
+    inline void unmap() noexcept
+    {
+        if (!_data)
+            return;
+
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        ::munmap(_data, _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+private:
+    void *_data = nullptr;
+    size_t _size = 0;
+};
+
+/**
+ * @brief Octree read straight out of a baked file, nothing is copied or rebuilt when it is opened.
+ *
+ * @tparam OBJ_TYPE stored byte for byte, a file can only be read back by a build with the same layout of OBJ_TYPE.
+ */
+template <typename OBJ_TYPE> class BakedOctree {
+    static_assert(std::is_trivially_copyable_v<OBJ_TYPE>, "baked objects are stored byte for byte");
+
+private:
+    static constexpr std::array<char, 8u> MAGIC{'O', 'C', 'T', 'B', 'A', 'K', 'E', '\0'};
+    static constexpr uint32_t VERSION = 1u;
+    static constexpr size_t ALIGNMENT = 64u;  // of every section, from the start of the file
+    static constexpr size_t BOUND_LANES = 6u; // min x, y, z then max x, y, z, as in BoundaryBoxBlock
+
+    struct Header {
+        std::array<char, 8u> magic;
+        uint32_t version;
+        uint32_t objectSize;
+        uint32_t nodeCount;
+        uint32_t itemCount;
+        uint64_t stride; // floats from one lane of item bounds to the next
+        uint64_t nodes;  // offsets of the sections from the start of the file
+        uint64_t bounds;
+        uint64_t objects;
+    };
+
+    struct Node {
+        BoundaryBox boundary;
+        uint32_t first; // own items in [first, own), items of the subtree in [first, last)
+        uint32_t own;
+        uint32_t last;
+        // index of each child node, 0 for none since the root is never a child, a quadtree only fills four
+        std::array<uint32_t, 8u> children;
+    };
+
+public:
+    BakedOctree(const BakedOctree &other) = delete;
+    BakedOctree &operator=(const BakedOctree &other) = delete;
+    ~BakedOctree() = default;
+
+    /**
+     * @brief Map a baked file.
+     *
+     * @return nullptr when the file is missing, truncated, corrupt, or was baked for another layout of OBJ_TYPE.
+     */
+    [[nodiscard]] static inline std::shared_ptr<const BakedOctree<OBJ_TYPE>>
+    map(const std::filesystem::path &path) noexcept
+    {
+        std::shared_ptr<BakedOctree<OBJ_TYPE>> baked(new BakedOctree<OBJ_TYPE>());
+
+        if (!baked->_file.map(path) || baked->_file.size() < sizeof(Header))
+            return nullptr;
+
+        const std::byte *data = baked->_file.data();
+        const size_t size = baked->_file.size();
+        const Header &header = *reinterpret_cast<const Header *>(data);
+
+        // every count is bounded by the file first, so the sums below cannot wrap
+        if (header.magic != MAGIC || header.version != VERSION || header.objectSize != sizeof(OBJ_TYPE) ||
+            header.nodeCount == 0 || header.nodeCount > size / sizeof(Node) ||
+            header.stride > size / (BOUND_LANES * sizeof(float)) || header.stride < header.itemCount ||
+            header.nodes > size || header.bounds > size || header.objects > size ||
+            header.nodes % ALIGNMENT != 0u || header.bounds % ALIGNMENT != 0u || header.objects % ALIGNMENT != 0u ||
+            header.nodes + header.nodeCount * sizeof(Node) > header.bounds ||
+            header.bounds + header.stride * BOUND_LANES * sizeof(float) > header.objects ||
+            header.objects + header.itemCount * sizeof(OBJ_TYPE) > size)
+            return nullptr;
+
+        baked->_header = &header;
+        baked->_nodes = reinterpret_cast<const Node *>(data + header.nodes);
+        baked->_bounds = reinterpret_cast<const float *>(data + header.bounds);
+        baked->_objects = reinterpret_cast<const OBJ_TYPE *>(data + header.objects);
+
+        if (!baked->valid())
+            return nullptr;
+        return baked;
+    }
+
+    /**
+     * @brief Write a snapshot to path in the baked format.
+     *
+     * @return false when the file cannot be written.
+     */
+    template <uint8_t DIMENSION>
+    [[nodiscard]] static inline bool bake(const std::filesystem::path &path,
+                                          const OctreeSnapshot<OBJ_TYPE, DIMENSION> &snapshot) noexcept
+    {
+        std::vector<Node> nodes;
+        BoundaryBoxBlock bounds;
+        std::vector<OBJ_TYPE> objects;
+
+        bounds.reserve(snapshot.size());
+        objects.reserve(snapshot.size());
+        flatten(snapshot, nodes, bounds, objects);
+
+        Header header{MAGIC, VERSION, static_cast<uint32_t>(sizeof(OBJ_TYPE)), static_cast<uint32_t>(nodes.size()),
+                      static_cast<uint32_t>(objects.size()), bounds.capacity(), 0u, 0u, 0u};
+        header.nodes = align(sizeof(Header));
+        header.bounds = align(header.nodes + nodes.size() * sizeof(Node));
+        header.objects = align(header.bounds + bounds.capacity() * BOUND_LANES * sizeof(float));
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const auto write = [&file](uint64_t offset, const void *data, size_t size) {
+            const std::vector<char> padding(offset - static_cast<uint64_t>(file.tellp()), '\0');
+            file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        };
+
+        write(0u, &header, sizeof(Header));
+        write(header.nodes, nodes.data(), nodes.size() * sizeof(Node));
+        write(header.bounds, bounds.data(), bounds.capacity() * BOUND_LANES * sizeof(float));
+        write(header.objects, objects.data(), objects.size() * sizeof(OBJ_TYPE));
+
+        return static_cast<bool>(file.flush());
+    }
+
+    [[nodiscard]] inline size_t size() const noexcept { return _header->itemCount; }
+
+    [[nodiscard]] inline const BoundaryBox &boundary() const noexcept { return _nodes[0].boundary; }
+
+    /**
+     * @brief Call visitor(object) for every item overlapping rArea, the objects are read from the mapping.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &>
+    inline void search(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        search(rArea, visitor, _nodes[0]);
+    }
+
+    /**
+     * @brief Call visitor(object) for every item whose bounds are at least partly inside frustum.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &>
+    inline void search(const Frustum &frustum, FUNC &&visitor) const noexcept
+    {
+        search(frustum, visitor, _nodes[0], Frustum::ALL_PLANES);
+    }
+
+    /**
+     * @brief The count items closest to point, nearest first, see DynamicOctree::nearest().
+     */
+    template <typename FILTER = OctreeAcceptAll>
+        requires std::predicate<FILTER &, const OBJ_TYPE &>
+    [[nodiscard]] inline std::vector<OctreeNeighbour<OBJ_TYPE>>
+    nearest(const glm::vec3 &point, size_t count, float maxDistance = std::numeric_limits<float>::infinity(),
+            FILTER &&filter = {}) const noexcept
+    {
+        struct Pending {
+            float distance2;
+            const Node *node;
+        };
+
+        const auto closer = [](const auto &a, const auto &b) { return a.distance2 < b.distance2; };
+        const auto farther = [](const auto &a, const auto &b) { return a.distance2 > b.distance2; };
+
+        std::vector<OctreeNeighbour<OBJ_TYPE>> found;
+        if (count == 0)
+            return found;
+
+        float bound = maxDistance * maxDistance;
+        std::vector<Pending> queue{{0.f, _nodes}};
+
+        while (!queue.empty())
+        {
+            std::pop_heap(queue.begin(), queue.end(), farther);
+            const auto [distance2, node] = queue.back();
+            queue.pop_back();
+
+            if (distance2 > bound)
+                break;
+
+            for (uint32_t i = node->first; i < node->own; ++i)
+            {
+                const float itemDistance2 = BoundaryBoxBlock::at(_bounds, _header->stride, i).squaredDistance(point);
+
+                if (itemDistance2 > bound || !filter(_objects[i]))
+                    continue;
+
+                found.push_back({_objects[i], itemDistance2});
+                std::push_heap(found.begin(), found.end(), closer);
+
+                if (found.size() > count)
+                {
+                    std::pop_heap(found.begin(), found.end(), closer);
+                    found.pop_back();
+                }
+
+                if (found.size() == count)
+                    bound = found.front().distance2;
+            }
+
+            for (uint32_t child : node->children)
+            {
+                if (!child)
+                    continue;
+
+                const float nodeDistance2 = _nodes[child].boundary.squaredDistance(point);
+
+                if (nodeDistance2 <= bound)
+                {
+                    queue.push_back({nodeDistance2, _nodes + child});
+                    std::push_heap(queue.begin(), queue.end(), farther);
+                }
+            }
+        }
+
+        std::sort_heap(found.begin(), found.end(), closer);
+        return found;
+    }
+
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &>
+    inline void items(FUNC &&visitor) const noexcept
+    {
+        for (uint32_t i = 0; i < _header->itemCount; ++i)
+            visitor(_objects[i]);
+    }
+
+private:
+    BakedOctree() = default;
+
+    /**
+     * @brief Whether the nodes only lead to items and nodes of the file, checked once so the searches never are.
+     *
+     * The children of a node are stored after it and their items within its subtree, so no walk can loop or leave
+     * the file.
+     */
+    [[nodiscard]] inline bool valid() const noexcept
+    {
+        for (uint32_t index = 0; index < _header->nodeCount; ++index)
+        {
+            const Node &node = _nodes[index];
+
+            if (node.first > node.own || node.own > node.last || node.last > _header->itemCount)
+                return false;
+
+            for (const uint32_t child : node.children)
+            {
+                if (child != 0u && (child <= index || child >= _header->nodeCount || _nodes[child].first < node.own ||
+                                    _nodes[child].last > node.last))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] static inline uint64_t align(uint64_t offset) noexcept
+    {
+        return (offset + ALIGNMENT - 1u) / ALIGNMENT * ALIGNMENT;
+    }
+
+    /**
+     * @brief Append node and its subtree depth first, the children of a node are stored after all its items.
+     *
+     * @return index of node.
+     */
+    template <uint8_t DIMENSION>
+    static inline uint32_t flatten(const OctreeSnapshot<OBJ_TYPE, DIMENSION> &node, std::vector<Node> &nodes,
+                                   BoundaryBoxBlock &bounds, std::vector<OBJ_TYPE> &objects) noexcept
+    {
+        const uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({node._boundary, static_cast<uint32_t>(objects.size()), 0u, 0u, {}});
+
+        for (size_t i = 0; i < node._items.size(); ++i)
+        {
+            bounds.push_back(node._bounds[i]);
+            objects.push_back(node._items[i]);
+        }
+        nodes[index].own = static_cast<uint32_t>(objects.size());
+
+        for (uint8_t i = 0; i < node._nodes.size(); ++i)
+        {
+            if (node._nodes[i])
+            {
+                const uint32_t child = flatten(*node._nodes[i], nodes, bounds, objects);
+                nodes[index].children[i] = child;
+            }
+        }
+        nodes[index].last = static_cast<uint32_t>(objects.size());
+
+        return index;
+    }
+
+    template <typename FUNC>
+    inline void search(const BoundaryBox &rArea, FUNC &visitor, const Node &node) const noexcept
+    {
+        BoundaryBoxBlock::overlaps(_bounds, _header->stride, rArea, node.first, node.own,
+                                   [this, &visitor](size_t i) { visitor(_objects[i]); });
+
+        for (uint32_t child : node.children)
+        {
+            if (!child)
+                continue;
+
+            if (rArea.contains(_nodes[child].boundary))
+                visit(visitor, _nodes[child]);
+            else if (rArea.overlaps(_nodes[child].boundary))
+                search(rArea, visitor, _nodes[child]);
+        }
+    }
+
+    template <typename FUNC>
+    inline void search(const Frustum &frustum, FUNC &visitor, const Node &node, uint8_t mask) const noexcept
+    {
+        for (uint32_t i = node.first; i < node.own; ++i)
+        {
+            if (frustum.classify(BoundaryBoxBlock::at(_bounds, _header->stride, i), mask) != Frustum::OUTSIDE)
+                visitor(_objects[i]);
+        }
+
+        for (uint32_t child : node.children)
+        {
+            if (!child)
+                continue;
+
+            const uint8_t childMask = frustum.classify(_nodes[child].boundary, mask);
+
+            if (childMask == 0u)
+                visit(visitor, _nodes[child]);
+            else if (childMask != Frustum::OUTSIDE)
+                search(frustum, visitor, _nodes[child], childMask);
+        }
+    }
+
+    /**
+     * @brief Every item of the subtree of node, a single run of the objects.
+     */
+    template <typename FUNC> inline void visit(FUNC &visitor, const Node &node) const noexcept
+    {
+        for (uint32_t i = node.first; i < node.last; ++i)
+            visitor(_objects[i]);
+    }
+
+private:
+    MappedFile _file;
+    const Header *_header = nullptr;
+    const Node *_nodes = nullptr;
+    const float *_bounds = nullptr; // lanes of a BoundaryBoxBlock, _header->stride floats apart
+    const OBJ_TYPE *_objects = nullptr;
+};
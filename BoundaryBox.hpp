@@ -39,6 +39,14 @@ public:
 
     ~BoundaryBox() = default;
 
+    [[nodiscard]] static inline BoundaryBox fromMinMax(const glm::vec3 &min, const glm::vec3 &max) noexcept
+    {
+        BoundaryBox box;
+        box._min = glm::min(min, max);
+        box._max = glm::max(min, max);
+        return box;
+    }
+
     [[nodiscard]] inline bool contains(const glm::vec3 &point) const noexcept
     {
         return (point.x >= _min.x && point.x <= _max.x && point.y >= _min.y && point.y <= _max.y && point.z >= _min.z &&
@@ -55,6 +63,43 @@ public:
                 _min.z <= other._min.z && _max.z >= other._max.z);
     }
 
+    /**
+     * @brief Squared distance from point to the closest point of the box, 0 when the point is inside.
+     */
+    [[nodiscard]] inline float squaredDistance(const glm::vec3 &point) const noexcept
+    {
+        const glm::vec3 gap = glm::max(glm::max(_min - point, point - _max), glm::vec3(0.f));
+        return glm::dot(gap, gap);
+    }
+
+    /**
+     * @brief Slab test of the ray origin + t * direction for t in [0, tmax], given by the inverse of its direction.
+     *
+     * @return the distance at which the ray enters the box, 0 when it starts inside, a negative value when it misses.
+     */
+    [[nodiscard]] inline float rayEntry(const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                                       float tmax) const noexcept
+    {
+        float tmin = 0.f;
+
+        for (uint8_t i = 0; i < 3u; ++i)
+        {
+            float t0 = (_min[i] - origin[i]) * inverseDirection[i];
+            float t1 = (_max[i] - origin[i]) * inverseDirection[i];
+
+            if (inverseDirection[i] < 0.f)
+                std::swap(t0, t1);
+
+            // written so that a NaN, from a ray running along a face, leaves the interval unchanged
+            tmin = t0 > tmin ? t0 : tmin;
+            tmax = t1 < tmax ? t1 : tmax;
+
+            if (tmax < tmin)
+                return -1.f;
+        }
+        return tmin;
+    }
+
     [[nodiscard]] inline const glm::vec3 &getPosition() const noexcept { return _min; }
     [[nodiscard]] inline const glm::vec3 &getMin() const noexcept { return _min; }
     [[nodiscard]] inline const glm::vec3 &getMax() const noexcept { return _max; }
@@ -0,0 +1,295 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file BoundaryBoxBlock.hpp
+ * @brief Structure-of-Arrays Storage of BoundaryBox with Batched Overlap Tests.
+ *
+ * The six bounds of every box are stored in six lanes of a single buffer
+ * (min x, min y, min z, max x, max y, max z), so a query box can be tested
+ * against 16 boxes at once with AVX-512, 8 at once with AVX2, and one at a
+ * time with the scalar fallback when neither is enabled at compile time.
+ * The end of a range that does not fill a batch goes through masked loads,
+ * so the small blocks of the octree nodes stay on the vector path.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include "BoundaryBox.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#    include <immintrin.h>
+#endif
+
+class BoundaryBoxBlock {
+private:
+    enum LANE : uint8_t {
+        MIN_X,
+        MIN_Y,
+        MIN_Z,
+        MAX_X,
+        MAX_Y,
+        MAX_Z,
+        LANE_COUNT
+    };
+
+    static constexpr size_t BATCH = 16u; // widest kernel, lanes are padded to it so full loads stay in bounds
+
+public:
+    BoundaryBoxBlock() = default;
+    BoundaryBoxBlock(const BoundaryBoxBlock &other)
+    {
+        reserve(other._size);
+        _size = other._size;
+        copy(other);
+    }
+    BoundaryBoxBlock(BoundaryBoxBlock &&other) noexcept = default;
+    BoundaryBoxBlock &operator=(const BoundaryBoxBlock &other)
+    {
+        if (this != &other)
+        {
+            _size = 0;
+            reserve(other._size);
+            _size = other._size;
+            copy(other);
+        }
+        return *this;
+    }
+    BoundaryBoxBlock &operator=(BoundaryBoxBlock &&other) noexcept = default;
+    ~BoundaryBoxBlock() = default;
+
+    [[nodiscard]] inline size_t size() const noexcept { return _size; }
+    [[nodiscard]] inline bool empty() const noexcept { return _size == 0; }
+    [[nodiscard]] inline size_t capacity() const noexcept { return _capacity; }
+    [[nodiscard]] inline size_t bytes() const noexcept { return _capacity * LANE_COUNT * sizeof(float); }
+
+    inline void clear() noexcept { _size = 0; }
+
+    /**
+     * @brief Shrink to count boxes, or grow with boxes left uninitialized.
+     */
+    inline void resize(size_t count)
+    {
+        reserve(count);
+        _size = count;
+    }
+
+    inline void reserve(size_t count)
+    {
+        if (count <= _capacity)
+            return;
+
+        const size_t capacity = (std::max(count, _capacity * 2u) + BATCH - 1u) / BATCH * BATCH;
+        std::unique_ptr<float[]> data = std::make_unique<float[]>(capacity * LANE_COUNT);
+
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            std::copy_n(this->lane(lane), _size, data.get() + lane * capacity);
+
+        _data = std::move(data);
+        _capacity = capacity;
+    }
+
+    inline void push_back(const BoundaryBox &box)
+    {
+        reserve(_size + 1u);
+        set(_size++, box);
+    }
+
+    inline void insert(size_t index, const BoundaryBox &box)
+    {
+        reserve(_size + 1u);
+
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            std::copy_backward(this->lane(lane) + index, this->lane(lane) + _size, this->lane(lane) + _size + 1u);
+
+        ++_size;
+        set(index, box);
+    }
+
+    inline void erase(size_t index) noexcept
+    {
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            std::copy(this->lane(lane) + index + 1u, this->lane(lane) + _size, this->lane(lane) + index);
+
+        --_size;
+    }
+
+    /**
+     * @brief Unordered erase, the last box takes the place of the removed one.
+     */
+    inline void swap_pop(size_t index) noexcept
+    {
+        --_size;
+
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            this->lane(lane)[index] = this->lane(lane)[_size];
+    }
+
+    inline void set(size_t index, const BoundaryBox &box) noexcept
+    {
+        lane(MIN_X)[index] = box.getMin().x;
+        lane(MIN_Y)[index] = box.getMin().y;
+        lane(MIN_Z)[index] = box.getMin().z;
+        lane(MAX_X)[index] = box.getMax().x;
+        lane(MAX_Y)[index] = box.getMax().y;
+        lane(MAX_Z)[index] = box.getMax().z;
+    }
+
+    [[nodiscard]] inline BoundaryBox operator[](size_t index) const noexcept
+    {
+        return at(_data.get(), _capacity, index);
+    }
+
+    /**
+     * @brief Call visitor(index) for every box in [first, last) that overlaps rArea.
+     */
+    template <typename FUNC>
+    inline void overlaps(const BoundaryBox &rArea, size_t first, size_t last, FUNC &&visitor) const noexcept
+    {
+        overlaps(_data.get(), _capacity, rArea, first, last, visitor);
+    }
+
+    template <typename FUNC> inline void overlaps(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        overlaps(rArea, 0u, _size, visitor);
+    }
+
+    /**
+     * @brief Same as above on boxes laid out like the ones of a block in memory it does not own, such as a mapped
+     * file: lane l of the boxes starts at data + l * stride.
+     */
+    template <typename FUNC>
+    static inline void overlaps(const float *data, size_t stride, const BoundaryBox &rArea, size_t first, size_t last,
+                                FUNC &&visitor) noexcept
+    {
+        const auto lane = [data, stride](uint8_t index) { return data + index * stride; };
+        size_t i = first;
+
+#if defined(__AVX512F__)
+        const __m512 qMinX = _mm512_set1_ps(rArea.getMin().x), qMaxX = _mm512_set1_ps(rArea.getMax().x);
+        const __m512 qMinY = _mm512_set1_ps(rArea.getMin().y), qMaxY = _mm512_set1_ps(rArea.getMax().y);
+        const __m512 qMinZ = _mm512_set1_ps(rArea.getMin().z), qMaxZ = _mm512_set1_ps(rArea.getMax().z);
+
+        for (; i + 16u <= last; i += 16u)
+        {
+            __mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(lane(MIN_X) + i), qMaxX, _CMP_LE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_loadu_ps(lane(MAX_X) + i), qMinX, _CMP_GE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_loadu_ps(lane(MIN_Y) + i), qMaxY, _CMP_LE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_loadu_ps(lane(MAX_Y) + i), qMinY, _CMP_GE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_loadu_ps(lane(MIN_Z) + i), qMaxZ, _CMP_LE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_loadu_ps(lane(MAX_Z) + i), qMinZ, _CMP_GE_OQ);
+            visit_mask(static_cast<uint32_t>(mask), i, visitor);
+        }
+
+        if (i < last) // the lanes are padded, masked loads finish the range in one more step
+        {
+            const __mmask16 tail = static_cast<__mmask16>((1u << (last - i)) - 1u);
+            __mmask16 mask = _mm512_mask_cmp_ps_mask(tail, _mm512_maskz_loadu_ps(tail, lane(MIN_X) + i), qMaxX,
+                                                     _CMP_LE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(tail, lane(MAX_X) + i), qMinX, _CMP_GE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(tail, lane(MIN_Y) + i), qMaxY, _CMP_LE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(tail, lane(MAX_Y) + i), qMinY, _CMP_GE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(tail, lane(MIN_Z) + i), qMaxZ, _CMP_LE_OQ);
+            mask = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(tail, lane(MAX_Z) + i), qMinZ, _CMP_GE_OQ);
+            visit_mask(static_cast<uint32_t>(mask), i, visitor);
+            i = last;
+        }
+#endif
+#if defined(__AVX2__)
+        const __m256 qMinX8 = _mm256_set1_ps(rArea.getMin().x), qMaxX8 = _mm256_set1_ps(rArea.getMax().x);
+        const __m256 qMinY8 = _mm256_set1_ps(rArea.getMin().y), qMaxY8 = _mm256_set1_ps(rArea.getMax().y);
+        const __m256 qMinZ8 = _mm256_set1_ps(rArea.getMin().z), qMaxZ8 = _mm256_set1_ps(rArea.getMax().z);
+
+        for (; i + 8u <= last; i += 8u)
+        {
+            __m256 hit = _mm256_cmp_ps(_mm256_loadu_ps(lane(MIN_X) + i), qMaxX8, _CMP_LE_OQ);
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(lane(MAX_X) + i), qMinX8, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(lane(MIN_Y) + i), qMaxY8, _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(lane(MAX_Y) + i), qMinY8, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(lane(MIN_Z) + i), qMaxZ8, _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_loadu_ps(lane(MAX_Z) + i), qMinZ8, _CMP_GE_OQ));
+            visit_mask(static_cast<uint32_t>(_mm256_movemask_ps(hit)), i, visitor);
+        }
+
+        if (i < last)
+        {
+            const __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(last - i)),
+                                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            __m256 hit = _mm256_cmp_ps(_mm256_maskload_ps(lane(MIN_X) + i, tail), qMaxX8, _CMP_LE_OQ);
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_maskload_ps(lane(MAX_X) + i, tail), qMinX8, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_maskload_ps(lane(MIN_Y) + i, tail), qMaxY8, _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_maskload_ps(lane(MAX_Y) + i, tail), qMinY8, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_maskload_ps(lane(MIN_Z) + i, tail), qMaxZ8, _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_maskload_ps(lane(MAX_Z) + i, tail), qMinZ8, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_castsi256_ps(tail));
+            visit_mask(static_cast<uint32_t>(_mm256_movemask_ps(hit)), i, visitor);
+            i = last;
+        }
+#endif
+
+        for (; i < last; ++i)
+        {
+            if (lane(MIN_X)[i] <= rArea.getMax().x && lane(MAX_X)[i] >= rArea.getMin().x &&
+                lane(MIN_Y)[i] <= rArea.getMax().y && lane(MAX_Y)[i] >= rArea.getMin().y &&
+                lane(MIN_Z)[i] <= rArea.getMax().z && lane(MAX_Z)[i] >= rArea.getMin().z)
+                visitor(i);
+        }
+    }
+
+    /**
+     * @brief Raw storage, lane l of the boxes starts at data() + l * capacity().
+     */
+    [[nodiscard]] inline const float *data() const noexcept { return _data.get(); }
+
+    [[nodiscard]] static inline BoundaryBox at(const float *data, size_t stride, size_t index) noexcept
+    {
+        const glm::vec3 min{data[MIN_X * stride + index], data[MIN_Y * stride + index], data[MIN_Z * stride + index]};
+        const glm::vec3 max{data[MAX_X * stride + index], data[MAX_Y * stride + index], data[MAX_Z * stride + index]};
+        return BoundaryBox::fromMinMax(min, max);
+    }
+
+private:
+    template <typename FUNC> static inline void visit_mask(uint32_t mask, size_t base, FUNC &visitor) noexcept
+    {
+        while (mask)
+        {
+            visitor(base + static_cast<size_t>(std::countr_zero(mask)));
+            mask &= mask - 1u;
+        }
+    }
+
+    [[nodiscard]] inline float *lane(uint8_t lane) noexcept { return _data.get() + lane * _capacity; }
+    [[nodiscard]] inline const float *lane(uint8_t lane) const noexcept { return _data.get() + lane * _capacity; }
+
+    inline void copy(const BoundaryBoxBlock &other) noexcept
+    {
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            std::copy_n(other.lane(lane), other._size, this->lane(lane));
+    }
+
+private:
+    std::unique_ptr<float[]> _data;
+    size_t _size = 0;
+    size_t _capacity = 0;
+};
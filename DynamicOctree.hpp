@@ -20,7 +20,9 @@
  * This file provides a dynamic octree implementation for efficient spatial
  * partitioning in 3D space. It allows for the insertion, searching, and removal
  * of objects within a defined 3D boundary. The octree is designed to handle
- * dynamic objects and can be resized as needed.
+ * dynamic objects and can be resized as needed. The number of axes split at
+ * every level is a template parameter, the same tree is a quadtree over x
+ * and z for flat worlds.
  *
  * The implementation is based on the work of javidx9, which can be
  * found in the following tutorial:
@@ -34,226 +36,2591 @@
 #pragma once
 
 #include "BoundaryBox.hpp"
+#include "BoundaryBoxBlock.hpp"
+#include "Frustum.hpp"
+#include "NodePool.hpp"
+#include "QuantizedBoundaryBoxBlock.hpp"
+#include "SlotMap.hpp"
+#include "ThreadPool.hpp"
 
 #include <SFML/Graphics.hpp>
 
 #include <algorithm>
 #include <array>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-template <typename OBJ_TYPE> struct OctreeItemLocation {
-    typename std::list<std::pair<BoundaryBox, OBJ_TYPE>> *container;
-    typename std::list<std::pair<BoundaryBox, OBJ_TYPE>>::iterator iterator;
+/**
+ * @tparam DIMENSION number of axes split at every level: 3 for an octree, 2 for a quadtree over x and z that keeps the
+ * y extent of the root in every node, 1 for a binary tree over x. The bounds are always 3D.
+ */
+template <typename OBJ_TYPE, uint8_t DIMENSION = 3u, typename BOUNDS_BLOCK = BoundaryBoxBlock> class DynamicOctree;
+
+template <typename OBJ_TYPE, uint8_t DIMENSION = 3u, typename BOUNDS_BLOCK = BoundaryBoxBlock>
+struct OctreeItemLocation {
+    DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = nullptr;
+    uint32_t index = 0;
+};
+
+/**
+ * @brief Default relink callback, for callers that do not keep the locations returned by insert().
+ *
+ * Removing an item moves the last item of its node into the freed slot, the relink callback receives that item and
+ * its new location so that the caller can update what it stored.
+ */
+struct OctreeNoRelink {
+    template <typename OBJ_TYPE, uint8_t DIMENSION, typename BOUNDS_BLOCK>
+    inline void operator()(const OBJ_TYPE &,
+                           const OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> &) const noexcept
+    {
+    }
+};
+
+/**
+ * @brief Default filter of the nearest() queries, every item is accepted.
+ */
+struct OctreeAcceptAll {
+    template <typename OBJ_TYPE> [[nodiscard]] inline bool operator()(const OBJ_TYPE &) const noexcept { return true; }
+};
+
+/**
+ * @brief An item found by a nearest() query, with its squared distance to the query point.
+ */
+template <typename OBJ_TYPE> struct OctreeNeighbour {
+    OBJ_TYPE item;
+    float distance2 = 0.f;
+};
+
+/**
+ * @brief Default hit test of the raycast() queries, the bounds of an item stand for its shape.
+ */
+struct OctreeBoundsHit {
+    template <typename OBJ_TYPE> [[nodiscard]] inline float operator()(const OBJ_TYPE &, float entry) const noexcept
+    {
+        return entry;
+    }
+};
+
+/**
+ * @brief The item hit by a raycast() query and the distance along the ray at which it is hit.
+ */
+template <typename OBJ_TYPE> struct OctreeRayHit {
+    OBJ_TYPE item;
+    float distance = 0.f;
+};
+
+/**
+ * @brief Totals of a value over the subtrees of a DynamicOctree, kept from one aggregate() call to the next.
+ *
+ * A subtree that did not change since its total was taken is not walked again. The value of an item must only change
+ * along with its bounds, otherwise clear() the cache.
+ */
+template <typename VALUE> class OctreeAggregate {
+public:
+    /**
+     * @param identity the total of no item, neutral for the combine function the cache is used with.
+     */
+    explicit OctreeAggregate(VALUE identity = {}) : _identity(std::move(identity)) {}
+
+    inline void clear() noexcept { _totals.clear(); }
+
+private:
+    template <typename, uint8_t, typename> friend class DynamicOctree;
+
+    struct Total {
+        VALUE value;
+        uint32_t epoch = 0; // of the tree when it was taken
+    };
+
+private:
+    VALUE _identity;
+    std::unordered_map<const void *, Total> _totals; // by node
+};
+
+/**
+ * @brief Mass, centre of mass and bounds of a group of items, the pseudo-object of DynamicOctree::approximate_visit().
+ */
+struct OctreeMass {
+    float mass = 0.f;
+    glm::vec3 moment{0.f}; // sum of the centres of the items weighted by their mass
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    /**
+     * @brief An item of the given mass, standing at the centre of its bounds.
+     */
+    [[nodiscard]] static inline OctreeMass of(float mass, const BoundaryBox &itemsize) noexcept
+    {
+        return {mass, itemsize.getCenter() * mass, itemsize.getMin(), itemsize.getMax()};
+    }
+
+    [[nodiscard]] inline glm::vec3 centre() const noexcept { return mass != 0.f ? moment / mass : (min + max) * 0.5f; }
+    [[nodiscard]] inline BoundaryBox bounds() const noexcept { return BoundaryBox::fromMinMax(min, max); }
+
+    [[nodiscard]] inline OctreeMass operator+(const OctreeMass &other) const noexcept
+    {
+        return {mass + other.mass, moment + other.moment, glm::min(min, other.min), glm::max(max, other.max)};
+    }
+};
+
+/**
+ * @brief An item waiting to be inserted by DynamicOctree::insert_bulk().
+ */
+template <typename OBJ_TYPE> struct OctreeBulkItem {
+    OBJ_TYPE item;
+    BoundaryBox itemsize;
+    uint8_t bucket = 0; // filled by the build: child that takes the item, or the child count when it stays
+};
+
+/**
+ * @brief Shape of a tree when DynamicOctree::stats() was called, the data to tune MAX_DEPTH and MAX_CAPACITY with.
+ */
+struct OctreeStats {
+    size_t nodes = 0;
+    size_t items = 0;
+    size_t maxItemsPerNode = 0;
+    size_t internalItems = 0;          // held by split nodes, because none of their children can hold them
+    size_t nodeBytes = 0;              // the whole node arena, the free slots included
+    size_t itemBytes = 0;              // the items and bounds of every node, up to their capacity
+    std::vector<size_t> nodesPerDepth; // the root is at depth 0
+    std::vector<size_t> itemsPerDepth;
+
+    [[nodiscard]] inline double meanItemsPerNode() const noexcept
+    {
+        return nodes ? static_cast<double>(items) / static_cast<double>(nodes) : 0.;
+    }
+
+    /**
+     * @brief Add the stats of another tree, as if both were one forest.
+     */
+    inline OctreeStats &operator+=(const OctreeStats &other)
+    {
+        nodes += other.nodes;
+        items += other.items;
+        maxItemsPerNode = std::max(maxItemsPerNode, other.maxItemsPerNode);
+        internalItems += other.internalItems;
+        nodeBytes += other.nodeBytes;
+        itemBytes += other.itemBytes;
+
+        nodesPerDepth.resize(std::max(nodesPerDepth.size(), other.nodesPerDepth.size()));
+        itemsPerDepth.resize(nodesPerDepth.size());
+
+        for (size_t depth = 0; depth < other.nodesPerDepth.size(); ++depth)
+        {
+            nodesPerDepth[depth] += other.nodesPerDepth[depth];
+            itemsPerDepth[depth] += other.itemsPerDepth[depth];
+        }
+
+        return *this;
+    }
+};
+
+/**
+ * @brief Work done by the queries of a thread, summed over every tree and snapshot it searched.
+ *
+ * It is always counted, at the cost of one visit() per node: a thread_local lookup and two adds. Read it before and
+ * after the queries to measure.
+ * Subtrees that lie fully inside a searched area have their items taken without any test, they are not counted.
+ */
+struct OctreeQueryStats {
+    size_t nodesVisited = 0; // nodes whose items were tested
+    size_t itemsTested = 0;
+
+    [[nodiscard]] static inline OctreeQueryStats &local() noexcept
+    {
+        thread_local OctreeQueryStats stats;
+        return stats;
+    }
+
+    inline void visit(size_t items) noexcept
+    {
+        ++nodesVisited;
+        itemsTested += items;
+    }
+
+    [[nodiscard]] inline OctreeQueryStats operator-(const OctreeQueryStats &other) const noexcept
+    {
+        return {nodesVisited - other.nodesVisited, itemsTested - other.itemsTested};
+    }
+};
+
+constexpr uint8_t MAX_DEPTH = 5;
+constexpr uint8_t MAX_CAPACITY = 4;
+constexpr float TIGHT_LOOSENESS = 1.f;
+
+template <typename OBJ_TYPE> class LinearOctreeContainer;
+template <typename OBJ_TYPE> class BakedOctree;
+
+/**
+ * @brief Immutable copy of an octree, that any thread can query while the tree keeps changing.
+ *
+ * Nodes are shared between versions: a snapshot taken after some changes only copies the nodes on the path of a
+ * change and points to the nodes of the previous snapshot for the rest. A version is freed with the last reader that
+ * holds it.
+ *
+ * @tparam VALUE copy of an item, taken when its node is copied.
+ */
+template <typename VALUE, uint8_t DIMENSION = 3u> class OctreeSnapshot {
+private:
+    static constexpr uint8_t CHILD_COUNT = 1u << DIMENSION;
+
+public:
+    [[nodiscard]] inline size_t size() const noexcept { return _count; }
+
+    [[nodiscard]] inline const BoundaryBox &boundary() const noexcept { return _boundary; }
+
+    /**
+     * @brief Call visitor(value) for every item overlapping rArea.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const VALUE &>
+    inline void search(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+        _bounds.overlaps(rArea, [this, &visitor](size_t i) { visitor(_items[i]); });
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            if (rArea.contains(_rNodes[i]))
+                _nodes[i]->items(visitor);
+            else if (rArea.overlaps(_rNodes[i]))
+                _nodes[i]->search(rArea, visitor);
+        }
+    }
+
+    /**
+     * @brief Call visitor(value) for every item whose bounds are at least partly inside frustum.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const VALUE &>
+    inline void search(const Frustum &frustum, FUNC &&visitor) const noexcept
+    {
+        search(frustum, visitor, Frustum::ALL_PLANES);
+    }
+
+    /**
+     * @brief The count items closest to point, nearest first, see DynamicOctree::nearest().
+     */
+    template <typename FILTER = OctreeAcceptAll>
+        requires std::predicate<FILTER &, const VALUE &>
+    [[nodiscard]] inline std::vector<OctreeNeighbour<VALUE>>
+    nearest(const glm::vec3 &point, size_t count, float maxDistance = std::numeric_limits<float>::infinity(),
+            FILTER &&filter = {}) const noexcept
+    {
+        struct Pending {
+            float distance2;
+            const OctreeSnapshot<VALUE, DIMENSION> *node;
+        };
+
+        const auto closer = [](const auto &a, const auto &b) { return a.distance2 < b.distance2; };
+        const auto farther = [](const auto &a, const auto &b) { return a.distance2 > b.distance2; };
+
+        std::vector<OctreeNeighbour<VALUE>> found;
+        if (count == 0)
+            return found;
+
+        float bound = maxDistance * maxDistance;
+        std::vector<Pending> queue{{0.f, this}};
+
+        while (!queue.empty())
+        {
+            std::pop_heap(queue.begin(), queue.end(), farther);
+            const auto [distance2, node] = queue.back();
+            queue.pop_back();
+
+            if (distance2 > bound)
+                break;
+
+            OctreeQueryStats::local().visit(node->_items.size());
+            for (size_t i = 0; i < node->_items.size(); ++i)
+            {
+                const float itemDistance2 = node->_bounds[i].squaredDistance(point);
+
+                if (itemDistance2 > bound || !filter(node->_items[i]))
+                    continue;
+
+                found.push_back({node->_items[i], itemDistance2});
+                std::push_heap(found.begin(), found.end(), closer);
+
+                if (found.size() > count)
+                {
+                    std::pop_heap(found.begin(), found.end(), closer);
+                    found.pop_back();
+                }
+
+                if (found.size() == count)
+                    bound = found.front().distance2;
+            }
+
+            for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+            {
+                if (!node->_nodes[i])
+                    continue;
+
+                const float nodeDistance2 = node->_rNodes[i].squaredDistance(point);
+
+                if (nodeDistance2 <= bound)
+                {
+                    queue.push_back({nodeDistance2, node->_nodes[i].get()});
+                    std::push_heap(queue.begin(), queue.end(), farther);
+                }
+            }
+        }
+
+        std::sort_heap(found.begin(), found.end(), closer);
+        return found;
+    }
+
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const VALUE &>
+    inline void items(FUNC &&visitor) const noexcept
+    {
+        for (const VALUE &item : _items)
+            visitor(item);
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i])
+                _nodes[i]->items(visitor);
+        }
+    }
+
+private:
+    template <typename, uint8_t, typename> friend class DynamicOctree;
+    template <typename> friend class LinearOctreeContainer;
+    template <typename> friend class BakedOctree;
+
+    template <typename FUNC>
+    inline void search(const Frustum &frustum, FUNC &visitor, uint8_t mask) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+        for (size_t i = 0; i < _items.size(); ++i)
+        {
+            if (frustum.classify(_bounds[i], mask) != Frustum::OUTSIDE)
+                visitor(_items[i]);
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            const uint8_t childMask = frustum.classify(_rNodes[i], mask);
+
+            if (childMask == 0u)
+                _nodes[i]->items(visitor);
+            else if (childMask != Frustum::OUTSIDE)
+                _nodes[i]->search(frustum, visitor, childMask);
+        }
+    }
+
+private:
+    BoundaryBox _boundary{};
+
+    std::array<BoundaryBox, CHILD_COUNT> _rNodes{};
+
+    std::array<std::shared_ptr<const OctreeSnapshot<VALUE, DIMENSION>>, CHILD_COUNT> _nodes{};
+
+    uint32_t _count = 0; // items in the whole subtree
+
+    std::vector<VALUE> _items{};
+    BoundaryBoxBlock _bounds{}; // bounds of _items, same order
 };
 
-constexpr uint8_t MAX_DEPTH = 5;
-constexpr uint8_t MAX_CAPACITY = 4;
+template <typename OBJ_TYPE, uint8_t DIMENSION, typename BOUNDS_BLOCK> class DynamicOctree {
+    static_assert(DIMENSION >= 1u && DIMENSION <= 3u, "the bounds have three axes");
+
+public:
+    static constexpr uint8_t CHILD_COUNT = 1u << DIMENSION;
+
+    // bit i of the index of a child tells on which side of SPLIT_AXES[i] it lies, y is only split by an octree
+    static constexpr std::array<uint8_t, 3u> SPLIT_AXES =
+        DIMENSION == 3u ? std::array<uint8_t, 3u>{0u, 1u, 2u} : std::array<uint8_t, 3u>{0u, 2u, 1u};
+
+    // the nodes store the bounds of their items in steps of their own box, see refine_with(). It saves memory at the
+    // cost of slower searches, the float block stays the default
+    static constexpr bool QUANTIZED = !std::same_as<BOUNDS_BLOCK, BoundaryBoxBlock>;
+
+    using Refine = std::function<BoundaryBox(const OBJ_TYPE &)>;
+
+private:
+    template <uint8_t> struct Unused {}; // stands for the members a float tree does not need
+
+    // position of every child in its parent, in halves of the parent along the split axes
+    static constexpr std::array<std::array<float, 3u>, CHILD_COUNT> CHILD_OFFSETS = [] {
+        std::array<std::array<float, 3u>, CHILD_COUNT> offsets{};
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+                offsets[i][SPLIT_AXES[bit]] = static_cast<float>((i >> bit) & 1u);
+        }
+        return offsets;
+    }();
+
+    using Pool = NodePool<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>>;
+
+    static constexpr size_t PARALLEL_GRAIN = 2048u; // smallest run of items built on its own task
+    static constexpr uint8_t JOIN_SPLIT_LEVELS = 2u; // levels of the tree split into parallel pair tasks
+    static constexpr size_t SWEEP_THRESHOLD = 128u;  // sets of boxes smaller than this are tested all against all
+    static constexpr size_t BATCH_GRAIN = 64u;       // queries of a search_batch() run on the same task
+
+    /**
+     * @brief Boxes and items gathered while joining, kept as SoA so ranges of it go through the SIMD overlap kernel.
+     */
+    struct JoinStack {
+        BoundaryBoxBlock bounds;
+        std::vector<OBJ_TYPE> items;
+
+        [[nodiscard]] inline size_t size() const noexcept { return items.size(); }
+
+        inline void reserve(size_t count)
+        {
+            bounds.reserve(count);
+            items.reserve(count);
+        }
+
+        inline void push_back(const BoundaryBox &itemsize, const OBJ_TYPE &item)
+        {
+            bounds.push_back(itemsize);
+            items.push_back(item);
+        }
+
+        inline void resize(size_t count) noexcept
+        {
+            bounds.resize(count);
+            items.erase(items.begin() + static_cast<std::ptrdiff_t>(count), items.end());
+        }
+    };
+
+    struct JoinItem {
+        BoundaryBox itemsize;
+        OBJ_TYPE item;
+    };
+
+    struct JoinTask {
+        const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node;
+        bool self;           // pairs within the subtree of node too, or only between it and inherited
+        JoinStack inherited; // items of the ancestors, or of a sibling subtree, that overlap node
+    };
+
+    friend Pool;
+
+public:
+    /**
+     * @param looseness scale applied to the bounds of every child node, 1 builds a classic tight octree. With a
+     * larger value the children overlap, so objects straddling a split plane still sink into deep nodes.
+     */
+    DynamicOctree(const BoundaryBox &boundary, const uint8_t capacity = MAX_CAPACITY, const uint8_t depth = MAX_DEPTH,
+                  const float looseness = TIGHT_LOOSENESS) noexcept
+        : _depth(depth), _capacity(capacity), _looseness(std::max(looseness, TIGHT_LOOSENESS)), _boundary(boundary),
+          _arena(std::make_unique<Pool>()), _pool(_arena.get()), _clock(&_epoch)
+    {
+        set_child_bounds(_boundary);
+
+        if constexpr (QUANTIZED)
+        {
+            _refine = std::make_unique<Refine>();
+            _exact = _refine.get();
+            _bounds.frame(_boundary, true); // the root also holds the items that stick out of it
+        }
+    }
+    DynamicOctree(const DynamicOctree &other) = delete;
+    DynamicOctree &operator=(const DynamicOctree &other) = delete;
+    ~DynamicOctree() = default;
+
+    inline void resize(const BoundaryBox &rArea) noexcept
+    {
+        if (_boundary == rArea)
+            return;
+
+        clear();
+        _boundary = rArea;
+        set_child_bounds(_boundary);
+
+        if constexpr (QUANTIZED)
+            _bounds.frame(_boundary, true);
+    }
+
+    /**
+     * @brief Build the tree again with other node parameters, on the root. The items are kept, relink receives each
+     * of them with its new location.
+     */
+    template <typename RELINK = OctreeNoRelink>
+    inline void rebuild(const uint8_t capacity, const uint8_t depth, const float looseness,
+                        ThreadPool *threadPool = nullptr, RELINK &&relink = {}) noexcept
+    {
+        std::vector<OctreeBulkItem<OBJ_TYPE>> items;
+        items.reserve(_count);
+        extract(items);
+        clear();
+
+        // the nodes are all gone, the new ones take the parameters of the root when they are allocated
+        _capacity = capacity;
+        _depth = depth;
+        _looseness = std::max(looseness, TIGHT_LOOSENESS);
+        set_child_bounds(_boundary);
+
+        insert_bulk(std::span(items), threadPool, relink);
+    }
+
+    /**
+     * @brief Grow the root until it holds rArea along the split axes, without building the tree again.
+     *
+     * Every step doubles the root towards rArea and hands the old root down as one of its children, so the subtrees
+     * stay as they are and the tree gains a level: its leaves keep their size. Only the items held by the root itself
+     * are inserted again, relink receives each of them with its new location. The next snapshot() copies every node.
+     */
+    template <typename RELINK = OctreeNoRelink>
+    inline void grow_to_include(const BoundaryBox &rArea, RELINK &&relink = {}) noexcept
+    {
+        const auto holds = [this, &rArea] {
+            for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+            {
+                const uint8_t axis = SPLIT_AXES[bit];
+
+                if (rArea.getMin()[axis] < _boundary.getMin()[axis] || rArea.getMax()[axis] > _boundary.getMax()[axis])
+                    return false;
+            }
+            return true;
+        };
+
+        while (!holds() && _depth != std::numeric_limits<uint8_t>::max())
+        {
+            glm::vec3 min = _boundary.getMin();
+            const glm::vec3 size = _boundary.getSize();
+            uint8_t index = 0;
+
+            // the old root takes the half away from rArea, a side rArea sticks out of both ways is grown next step
+            for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+            {
+                const uint8_t axis = SPLIT_AXES[bit];
+
+                if (rArea.getMin()[axis] < min[axis])
+                {
+                    index |= static_cast<uint8_t>(1u << bit);
+                    min[axis] -= size[axis];
+                }
+            }
+
+            grow(BoundaryBox(min, size * on_split_axes(2.f)), index, relink);
+        }
+    }
+
+    /**
+     * @brief Hand the root over to its only child for as long as that child holds every item, the inverse of
+     * grow_to_include().
+     *
+     * The tree loses a level per step and the subtrees stay as they are. Only the items held by the child itself are
+     * inserted again, relink receives each of them with its new location.
+     */
+    template <typename RELINK = OctreeNoRelink> inline void shrink_to_fit(RELINK &&relink = {}) noexcept
+    {
+        while (_items.empty())
+        {
+            const auto first = std::find_if(_nodes.begin(), _nodes.end(), [](const auto *node) { return node; });
+
+            if (first == _nodes.end() || std::find_if(first + 1, _nodes.end(), [](const auto *node) { return node; }) !=
+                                             _nodes.end())
+                return;
+
+            shrink(*first, relink);
+        }
+    }
+
+    [[nodiscard]] inline uint8_t capacity() const noexcept { return _capacity; }
+    [[nodiscard]] inline uint8_t depth() const noexcept { return _depth; }
+    [[nodiscard]] inline float looseness() const noexcept { return _looseness; }
+
+    /**
+     * @brief Remove every item and give all the child nodes back to the arena in one go.
+     *
+     * The boundary is kept, so the tree can be refilled right away.
+     */
+    inline void clear() noexcept
+    {
+        _items.clear();
+        _bounds.clear();
+        _nodes.fill(nullptr);
+        _count = 0;
+        _split = false;
+        touch();
+
+        if (_arena)
+            _arena->release();
+    }
+
+    [[nodiscard, deprecated("Use DynamicOctreeContainer::size() instead.")]] inline size_t size() const noexcept
+    {
+        return _count;
+    }
+
+    /**
+     * @brief Insert an item in the deepest node that can hold it.
+     *
+     * A leaf that is already full is split first and its items are pushed down into the children that can hold them.
+     *
+     * @param relink called for every item that was already in the tree and moved to another node or slot.
+     */
+    template <typename RELINK = OctreeNoRelink>
+    [[nodiscard]] inline OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> insert(const OBJ_TYPE &item,
+                                                                        const BoundaryBox &itemsize,
+                                                                        RELINK &&relink = {}) noexcept
+    {
+        ++_count;
+
+        if (!_split && _depth != 0 && _items.size() >= _capacity)
+            split(relink);
+
+        if (_split)
+        {
+            const uint8_t i = octant(itemsize.getCenter());
+
+            if (_rNodes[i].contains(itemsize))
+                return child(i)->insert(item, itemsize, relink);
+        }
+
+        _items.emplace_back(item);
+        _bounds.push_back(itemsize);
+        touch();
+        return {this, static_cast<uint32_t>(_items.size() - 1u)};
+    }
+
+    /**
+     * @brief Insert many items at once.
+     *
+     * On an empty tree every node is built in a single pass: its items are scattered by child, which is one digit of
+     * their Morton code, the node keeps the ones none of its children can hold and hands each child its contiguous
+     * run of the rest. The subtrees are built in parallel on threadPool when one is given, each in its own pool that
+     * the tree adopts afterwards. A tree that already holds items falls back to one insert() per item.
+     *
+     * @param items reordered in place.
+     * @param relink called with every item and its location, concurrently for different items when threadPool is set.
+     */
+    template <typename RELINK = OctreeNoRelink>
+    inline void insert_bulk(std::span<OctreeBulkItem<OBJ_TYPE>> items, ThreadPool *threadPool = nullptr,
+                            RELINK &&relink = {}) noexcept
+    {
+        if (_count != 0)
+        {
+            for (const OctreeBulkItem<OBJ_TYPE> &entry : items)
+                relink(entry.item, insert(entry.item, entry.itemsize, relink));
+            return;
+        }
+
+        std::vector<OctreeBulkItem<OBJ_TYPE>> scratch(items.size());
+        build(items, scratch, threadPool, relink);
+    }
+
+    [[nodiscard]] inline std::list<OBJ_TYPE> search(const BoundaryBox &rArea) const noexcept
+    {
+        std::list<OBJ_TYPE> listItems;
+        search(rArea, listItems);
+        return listItems;
+    }
+
+    inline void search(const BoundaryBox &rArea, std::list<OBJ_TYPE> &listItems) const noexcept
+    {
+        search(rArea, [&listItems](const OBJ_TYPE &item) { listItems.emplace_back(item); });
+    }
+
+    /**
+     * @brief Stream every item overlapping rArea into an output iterator.
+     *
+     * Use it with std::back_inserter on a vector owned by the caller to reuse
+     * its capacity from one frame to the next.
+     */
+    template <std::output_iterator<const OBJ_TYPE &> OUT_IT>
+    inline OUT_IT search(const BoundaryBox &rArea, OUT_IT out) const noexcept
+    {
+        search(rArea, [&out](const OBJ_TYPE &item) { *out++ = item; });
+        return out;
+    }
+
+    /**
+     * @brief Call visitor(item) for every item overlapping rArea, without building any container.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &>
+    inline void search(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+        overlapping(rArea, 0u, _items.size(), [this, &visitor](size_t i) { visitor(_items[i]); });
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            if (rArea.contains(_rNodes[i]))
+                _nodes[i]->items(visitor);
+            else if (rArea.overlaps(_rNodes[i]))
+                _nodes[i]->search(rArea, visitor);
+        }
+    }
+
+    /**
+     * @brief Call visitor(query, item) for every item overlapping areas[query], in a single walk of the tree.
+     *
+     * Every node carries the list of the queries still active below it, so the top levels are walked once for the
+     * whole batch and the items of a node are tested against all of its queries while they are in cache. The queries
+     * are walked in the order of their centre along the Morton curve of the tree, so neighbours share their runs.
+     *
+     * @param threadPool when given, the batch is split into runs of queries searched in parallel. visitor is then
+     * called from several threads at once, but never for the same query.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, uint32_t, const OBJ_TYPE &>
+    inline void search_batch(std::span<const BoundaryBox> areas, FUNC &&visitor,
+                             ThreadPool *threadPool = nullptr) const noexcept
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> keys(areas.size()); // curve key, query
+        for (uint32_t query = 0; query < areas.size(); ++query)
+            keys[query] = {curve_key(areas[query].getCenter()), query};
+        std::sort(keys.begin(), keys.end());
+
+        const size_t tasks = (areas.size() + BATCH_GRAIN - 1u) / BATCH_GRAIN;
+
+        parallel_for(tasks > 1u ? threadPool : nullptr, tasks, [this, areas, &keys, &visitor](size_t k) {
+            const size_t first = k * BATCH_GRAIN;
+            const size_t count = std::min(BATCH_GRAIN, areas.size() - first);
+            std::array<uint32_t, BATCH_GRAIN> active;
+
+            for (size_t n = 0; n < count; ++n)
+                active[n] = keys[first + n].second;
+
+            search_batch(areas, std::span<const uint32_t>(active.data(), count), visitor);
+        });
+    }
+
+    /**
+     * @brief Fill results[query] with the items overlapping areas[query], reusing the capacity of the vectors.
+     */
+    inline void search_batch(std::span<const BoundaryBox> areas, std::vector<std::vector<OBJ_TYPE>> &results,
+                             ThreadPool *threadPool = nullptr) const noexcept
+    {
+        results.resize(areas.size());
+        for (std::vector<OBJ_TYPE> &found : results)
+            found.clear();
+
+        search_batch(
+            areas, [&results](uint32_t query, const OBJ_TYPE &item) { results[query].emplace_back(item); },
+            threadPool);
+    }
+
+    /**
+     * @brief Number of items overlapping rArea, the subtrees inside it are counted without being walked.
+     */
+    [[nodiscard]] inline size_t count(const BoundaryBox &rArea) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+
+        size_t found = 0;
+        overlapping(rArea, 0u, _items.size(), [&found](size_t) { ++found; });
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            if (rArea.contains(_rNodes[i]))
+                found += _nodes[i]->_count;
+            else if (rArea.overlaps(_rNodes[i]))
+                found += _nodes[i]->count(rArea);
+        }
+
+        return found;
+    }
+
+    /**
+     * @brief Combine value(item) over the items overlapping rArea, like their total mass or their combined bounds.
+     *
+     * The totals of the subtrees inside rArea are taken from cache, and only walked again below the nodes that
+     * changed since the cache last saw them. A cache belongs to a single tree, value and combine function.
+     *
+     * @param value value(item), or value(item, bounds) when it needs the bounds of the item.
+     * @param combine combine(a, b) merges two values, in any order and grouping.
+     */
+    template <typename VALUE, typename FUNC, typename COMBINE = std::plus<>>
+        requires(std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &>, VALUE> ||
+                 std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &, const BoundaryBox &>, VALUE>) &&
+                std::convertible_to<std::invoke_result_t<COMBINE &, const VALUE &, const VALUE &>, VALUE>
+    [[nodiscard]] inline VALUE aggregate(const BoundaryBox &rArea, OctreeAggregate<VALUE> &cache, FUNC &&value,
+                                         COMBINE &&combine = {}) noexcept
+    {
+        // the totals of released nodes stay behind, the arena reuses their addresses so they stay few
+        if (cache._totals.size() > 2u * (_arena->capacity() + 1u))
+            cache.clear();
+
+        return aggregate(rArea, cache, value, combine, stamp());
+    }
+
+    /**
+     * @brief Barnes-Hut walk around point: visitor(item) for the items close to it, far(summary) for the subtrees
+     * whose items are far enough to be taken as a single OctreeMass.
+     *
+     * A subtree is far when its items lie outside point and their bounds, seen from their centre of mass, are smaller
+     * than theta times their distance to point. The summaries are kept in cache like the totals of aggregate(), so
+     * only the subtrees that changed are summed again. A theta of 0 visits every item.
+     *
+     * @param mass mass(item) gives the mass of each item, which stands at the centre of its bounds.
+     */
+    template <typename FUNC, typename NEAR, typename FAR>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &>, float> &&
+                 std::invocable<NEAR &, const OBJ_TYPE &> && std::invocable<FAR &, const OctreeMass &>
+    inline void approximate_visit(const glm::vec3 &point, float theta, OctreeAggregate<OctreeMass> &cache,
+                                  FUNC &&mass, NEAR &&visitor, FAR &&far) noexcept
+    {
+        if (cache._totals.size() > 2u * (_arena->capacity() + 1u))
+            cache.clear();
+
+        const auto value = [&mass](const OBJ_TYPE &item, const BoundaryBox &itemsize) {
+            return OctreeMass::of(mass(item), itemsize);
+        };
+        std::plus<> combine;
+
+        approximate_visit(point, theta * theta, cache, value, combine, visitor, far, stamp());
+    }
+
+    /**
+     * @brief The count items closest to point, nearest first, measured to their bounds.
+     *
+     * @param maxDistance items farther than this are ignored.
+     * @param filter items for which filter(item) is false are skipped.
+     */
+    template <typename FILTER = OctreeAcceptAll>
+        requires std::predicate<FILTER &, const OBJ_TYPE &>
+    [[nodiscard]] inline std::vector<OctreeNeighbour<OBJ_TYPE>>
+    nearest(const glm::vec3 &point, size_t count, float maxDistance = std::numeric_limits<float>::infinity(),
+            FILTER &&filter = {}) const noexcept
+    {
+        std::vector<OctreeNeighbour<OBJ_TYPE>> found;
+        nearest(point, count, found, maxDistance, filter);
+        return found;
+    }
+
+    /**
+     * @brief Same as above, into a vector owned by the caller so its capacity is reused.
+     *
+     * Nodes are visited best-first from a queue ordered by their distance to point. The items found so far are kept
+     * in a heap bounded to count, and the search stops as soon as the closest node left is farther than the worst of
+     * them.
+     */
+    template <typename FILTER = OctreeAcceptAll>
+        requires std::predicate<FILTER &, const OBJ_TYPE &>
+    inline void nearest(const glm::vec3 &point, size_t count, std::vector<OctreeNeighbour<OBJ_TYPE>> &found,
+                        float maxDistance = std::numeric_limits<float>::infinity(), FILTER &&filter = {}) const noexcept
+    {
+        struct Pending {
+            float distance2;
+            const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node;
+        };
+
+        const auto closer = [](const auto &a, const auto &b) { return a.distance2 < b.distance2; };
+        const auto farther = [](const auto &a, const auto &b) { return a.distance2 > b.distance2; };
+
+        found.clear();
+        if (count == 0)
+            return;
+
+        float bound = maxDistance * maxDistance;
+        std::vector<Pending> queue{{0.f, this}}; // the root also holds the items that stick out of its boundary
+
+        while (!queue.empty())
+        {
+            std::pop_heap(queue.begin(), queue.end(), farther);
+            const auto [distance2, node] = queue.back();
+            queue.pop_back();
+
+            if (distance2 > bound)
+                break;
+
+            OctreeQueryStats::local().visit(node->_items.size());
+            for (size_t i = 0; i < node->_items.size(); ++i)
+            {
+                float itemDistance2 = node->_bounds[i].squaredDistance(point);
+
+                if constexpr (QUANTIZED)
+                {
+                    // the stored bounds only give a lower bound, the exact distance is taken for the candidates
+                    if (itemDistance2 <= bound)
+                        itemDistance2 = node->item_bounds(i).squaredDistance(point);
+                }
+
+                if (itemDistance2 > bound || !filter(node->_items[i]))
+                    continue;
+
+                found.push_back({node->_items[i], itemDistance2});
+                std::push_heap(found.begin(), found.end(), closer);
+
+                if (found.size() > count)
+                {
+                    std::pop_heap(found.begin(), found.end(), closer);
+                    found.pop_back();
+                }
+
+                if (found.size() == count)
+                    bound = found.front().distance2;
+            }
+
+            for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+            {
+                if (!node->_nodes[i])
+                    continue;
+
+                const float nodeDistance2 = node->_rNodes[i].squaredDistance(point);
+
+                if (nodeDistance2 <= bound)
+                {
+                    queue.push_back({nodeDistance2, node->_nodes[i]});
+                    std::push_heap(queue.begin(), queue.end(), farther);
+                }
+            }
+        }
+
+        std::sort_heap(found.begin(), found.end(), closer);
+    }
+
+    /**
+     * @brief Closest item hit by the ray origin + t * direction for t in [0, tmax].
+     *
+     * The children crossed by the ray are visited front to back, and the traversal stops at the first child that
+     * the ray enters beyond the closest hit found so far.
+     *
+     * @param hit hit(item, entry) gets the distance at which the ray enters the bounds of the item and returns the
+     * distance of the actual hit, infinity when the item is missed. It is only called for the items whose bounds are
+     * crossed.
+     */
+    template <typename FUNC = OctreeBoundsHit>
+        requires std::is_invocable_r_v<float, FUNC &, const OBJ_TYPE &, float>
+    [[nodiscard]] inline std::optional<OctreeRayHit<OBJ_TYPE>> raycast(const glm::vec3 &origin,
+                                                                       const glm::vec3 &direction, float tmax,
+                                                                       FUNC &&hit = {}) const noexcept
+    {
+        std::optional<OctreeRayHit<OBJ_TYPE>> closest;
+        raycast(origin, glm::vec3(1.f) / direction, tmax, hit, closest);
+        return closest;
+    }
+
+    /**
+     * @brief Whether any item is hit by the ray origin + t * direction for t in [0, tmax), for shadow and occlusion
+     * rays. The traversal stops at the first hit, see raycast() for hit.
+     */
+    template <typename FUNC = OctreeBoundsHit>
+        requires std::is_invocable_r_v<float, FUNC &, const OBJ_TYPE &, float>
+    [[nodiscard]] inline bool raycast_any(const glm::vec3 &origin, const glm::vec3 &direction, float tmax,
+                                          FUNC &&hit = {}) const noexcept
+    {
+        return raycast_any(origin, glm::vec3(1.f) / direction, tmax, hit);
+    }
+
+    /**
+     * @brief Call visitor(item) for every item whose bounds are at least partly inside frustum.
+     *
+     * A child fully inside a plane stops testing it, and a child fully inside the frustum has all its items visited
+     * without any further test.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &>
+    inline void search(const Frustum &frustum, FUNC &&visitor) const noexcept
+    {
+        search(frustum, visitor, Frustum::ALL_PLANES);
+    }
+
+    /**
+     * @brief Start a new epoch of changes on the root and return the one that ends, for search_changes().
+     */
+    [[nodiscard]] inline uint32_t stamp() noexcept { return _epoch++; }
+
+    /**
+     * @brief Call visitor(item, inside) for the items whose overlap with the searched area may differ from a search
+     * of previous done at epoch since, inside tells whether the item overlaps rArea now.
+     *
+     * Every item of the nodes changed since then that overlap either area is visited. The other subtrees are only
+     * entered where previous and rArea differ, and only the items that crossed from one area to the other are
+     * visited there, so a still area over a still tree costs nothing. Items that were removed, or moved to a node
+     * overlapping neither area, are not seen.
+     */
+    template <typename AREA, typename FUNC>
+        requires(std::same_as<AREA, BoundaryBox> || std::same_as<AREA, Frustum>) &&
+                std::invocable<FUNC &, const OBJ_TYPE &, bool>
+    inline void search_changes(const AREA &previous, const AREA &rArea, uint32_t since, FUNC &&visitor) const noexcept
+    {
+        search_changes(previous, rArea, since, !(previous == rArea), visitor);
+    }
+
+    /**
+     * @brief Call visitor(a, b) once for every pair of items whose bounds overlap.
+     *
+     * Every node tests its items against each other and against the items of its ancestors that overlap its bounds,
+     * then the subtrees of two children whose bounds overlap are joined with each other.
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &, const OBJ_TYPE &>
+    inline void overlapping_pairs(FUNC &&visitor) const noexcept
+    {
+        JoinStack stack;
+        self_join(stack, 0u, visitor);
+    }
+
+    /**
+     * @brief Append every pair of items whose bounds overlap to pairs, the subtrees are joined in parallel on
+     * threadPool when one is given.
+     */
+    inline void overlapping_pairs(std::vector<std::pair<OBJ_TYPE, OBJ_TYPE>> &pairs,
+                                  ThreadPool *threadPool = nullptr) const noexcept
+    {
+        const auto emit = [&pairs](const OBJ_TYPE &a, const OBJ_TYPE &b) { pairs.emplace_back(a, b); };
+
+        if (!threadPool || _count < PARALLEL_GRAIN)
+            return overlapping_pairs(emit);
+
+        std::vector<JoinTask> tasks;
+        JoinStack stack;
+        split_join(stack, 0u, emit, tasks, JOIN_SPLIT_LEVELS);
+
+        std::vector<std::vector<std::pair<OBJ_TYPE, OBJ_TYPE>>> found(tasks.size());
+
+        threadPool->parallel_for(tasks.size(), [&tasks, &found](size_t k) {
+            const auto emitTask = [&found, k](const OBJ_TYPE &a, const OBJ_TYPE &b) { found[k].emplace_back(a, b); };
+            JoinStack taskStack = std::move(tasks[k].inherited);
+
+            if (tasks[k].self)
+                tasks[k].node->self_join(taskStack, 0u, emitTask);
+            else
+                tasks[k].node->list_join(taskStack, 0u, emitTask);
+        });
+
+        for (const auto &taskPairs : found)
+            pairs.insert(pairs.end(), taskPairs.begin(), taskPairs.end());
+    }
+
+    inline void items(std::list<OBJ_TYPE> &listItems) const noexcept
+    {
+        items([&listItems](const OBJ_TYPE &item) { listItems.emplace_back(item); });
+    }
+
+    template <typename FUNC>
+        requires std::invocable<FUNC &, const OBJ_TYPE &>
+    inline void items(FUNC &&visitor) const noexcept
+    {
+        for (const OBJ_TYPE &item : _items)
+            visitor(item);
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i])
+                _nodes[i]->items(visitor);
+        }
+    }
+
+    [[nodiscard]] inline const BoundaryBox &boundary() const noexcept { return _boundary; }
+
+    /**
+     * @brief Give a quantized tree the exact bounds of its items, on the root.
+     *
+     * Its nodes only keep the bounds of their items in steps of their own box, a few times smaller than floats but a
+     * little larger than the items. The searches take exact(item) for the candidates near the border of the query that
+     * those steps do not settle, so they stay conservative until it is set. Each of those calls goes through the
+     * std::function, which is why a quantized tree searches slower than a float one.
+     */
+    inline void refine_with(Refine exact) noexcept
+        requires QUANTIZED
+    {
+        *_refine = std::move(exact);
+    }
+
+    /**
+     * @brief Walk the tree to measure its shape and memory, on the root.
+     */
+    [[nodiscard]] inline OctreeStats stats() const noexcept
+    {
+        OctreeStats shape;
+        shape.nodeBytes = sizeof(*this) + _arena->capacity() * sizeof(*this);
+        stats(shape, 0u);
+        return shape;
+    }
+
+    /**
+     * @brief Immutable copy of the tree holding value(item) for every item, for readers that must not lock it.
+     *
+     * Only the nodes changed since the previous snapshot are copied, the others are shared with it. It must not run
+     * concurrently with any change to the tree.
+     *
+     * @param previous the last snapshot taken from this tree, or nullptr to copy every node.
+     */
+    template <typename FUNC = std::identity,
+              typename VALUE = std::remove_cvref_t<std::invoke_result_t<FUNC &, const OBJ_TYPE &>>>
+    [[nodiscard]] inline std::shared_ptr<const OctreeSnapshot<VALUE, DIMENSION>>
+    snapshot(const std::type_identity_t<std::shared_ptr<const OctreeSnapshot<VALUE, DIMENSION>>> &previous,
+             FUNC &&value = {}) noexcept
+    {
+        // the root grew or shrank since the previous snapshot, so its nodes stand at other places in it
+        if (previous && !(previous->_boundary == _boundary))
+            return snapshot<FUNC &, VALUE>(nullptr, value);
+
+        if (!_dirty && previous)
+            return previous;
+
+        auto node = std::make_shared<OctreeSnapshot<VALUE, DIMENSION>>();
+        node->_boundary = _boundary;
+        node->_rNodes = _rNodes;
+        node->_count = _count;
+        node->_items.reserve(_items.size());
+
+        if constexpr (QUANTIZED)
+        {
+            node->_bounds.reserve(_items.size());
+            for (size_t i = 0; i < _items.size(); ++i)
+                node->_bounds.push_back(item_bounds(i));
+        }
+        else
+            node->_bounds = _bounds;
+
+        for (const OBJ_TYPE &item : _items)
+            node->_items.emplace_back(value(item));
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i])
+                node->_nodes[i] = _nodes[i]->template snapshot<FUNC &, VALUE>(previous ? previous->_nodes[i] : nullptr,
+                                                                             value);
+        }
+
+        _dirty = false;
+        return node;
+    }
+
+    [[nodiscard, deprecated("Use remove(OctreeItemLocation) instead.")]] inline bool remove(OBJ_TYPE pItem) noexcept
+    {
+        auto it = std::find(_items.begin(), _items.end(), pItem);
+
+        if (it != _items.end())
+        {
+            remove(OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>{
+                this, static_cast<uint32_t>(it - _items.begin())});
+            return true;
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i] && _nodes[i]->remove(pItem))
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Remove the item stored at location, the last item of the same node is moved into its slot.
+     *
+     * @param relink called with the moved item and its new location, if any item was moved.
+     */
+    template <typename RELINK = OctreeNoRelink>
+    inline void remove(const OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> &location,
+                       RELINK &&relink = {}) noexcept
+    {
+        DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> &node = *location.node;
+
+        node.erase(location.index, relink);
+        node.shrink(relink);
+    }
+
+    /**
+     * @brief Remove many items at once, grouped by node.
+     *
+     * The items of a node are erased from the highest index down, so the item moved into each freed slot is never
+     * one that is still pending. The counters are updated once per node and the subtrees are merged only after every
+     * item is gone.
+     */
+    template <typename RELINK = OctreeNoRelink>
+    inline void remove_batch(std::span<const OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>> locations,
+                             RELINK &&relink = {}) noexcept
+    {
+        std::vector<OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>> sorted(locations.begin(), locations.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+            return a.node != b.node ? std::less<>()(a.node, b.node) : a.index > b.index;
+        });
+        // an item given twice would erase whichever item took its slot the first time
+        sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                                 [](const auto &a, const auto &b) { return a.node == b.node && a.index == b.index; }),
+                     sorted.end());
+
+        std::vector<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *> nodes;
+
+        for (size_t first = 0, last = 0; first < sorted.size(); first = last)
+        {
+            DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = sorted[first].node;
+
+            for (last = first; last < sorted.size() && sorted[last].node == node; ++last)
+                node->erase(sorted[last].index, relink);
+
+            node->discount(static_cast<uint32_t>(last - first));
+            nodes.emplace_back(node);
+        }
+
+        std::vector<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *> targets;
+
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node : nodes)
+        {
+            if (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *target = node->shrink_target())
+                targets.emplace_back(target);
+        }
+
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+        const std::vector<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *> candidates = targets;
+        std::erase_if(targets, [&candidates](const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *target) {
+            for (const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = target->_parent; node;
+                 node = node->_parent)
+            {
+                if (std::binary_search(candidates.begin(), candidates.end(), node))
+                    return true;
+            }
+            return false;
+        });
+
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *target : targets)
+            target->reduce(relink);
+    }
+
+    /**
+     * @brief Update the bounds of an item in place, as long as it did not leave its node.
+     *
+     * @return false when the item has to be removed and inserted again.
+     */
+    [[nodiscard]] inline bool update(const OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> &location,
+                                     const BoundaryBox &itemsize) noexcept
+    {
+        DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> &node = *location.node;
+
+        if (node._parent && !node._boundary.contains(itemsize))
+            return false;
+
+        // an item that stands still leaves its node unchanged for the snapshots and the cached searches, a quantized
+        // node cannot tell since the item may have moved within the same steps
+        if constexpr (!QUANTIZED)
+        {
+            if (node._bounds[location.index] == itemsize)
+                return true;
+        }
+
+        node._bounds.set(location.index, itemsize);
+        node.touch();
+        return true;
+    }
+
+#ifdef DEBUG
+    inline void draw(sf::RenderWindow &window, const BoundaryBox &rArea) const noexcept
+    {
+        sf::RectangleShape rectangle;
+        rectangle.setPosition({rArea.getMin().x, rArea.getMin().y});
+        rectangle.setSize({rArea.getMax().x - rArea.getMin().x, rArea.getMax().y - rArea.getMin().y});
+        rectangle.setFillColor(sf::Color::Transparent);
+        rectangle.setOutlineColor(sf::Color::Green);
+        rectangle.setOutlineThickness(1);
+        window.draw(rectangle);
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i])
+                _nodes[i]->draw(window, rArea);
+        }
+    }
+#endif
+
+private:
+    DynamicOctree(const BoundaryBox &boundary, const uint8_t capacity, const uint8_t depth, const float looseness,
+                  Pool *pool, DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *parent) noexcept
+        : _depth(depth), _capacity(capacity), _looseness(looseness), _boundary(boundary), _pool(pool),
+          _parent(parent), _clock(parent->_clock), _exact(parent->_exact), _changed(*_clock)
+    {
+        set_child_bounds(scale(_boundary, 1.f / _looseness));
+
+        if constexpr (QUANTIZED)
+            _bounds.frame(_boundary, false);
+    }
+
+    /**
+     * @brief Scale box around its center along the split axes, the other axes span the whole tree anyway.
+     */
+    [[nodiscard]] static inline BoundaryBox scale(const BoundaryBox &box, float factor) noexcept
+    {
+        if (factor == TIGHT_LOOSENESS)
+            return box;
+
+        const glm::vec3 size = box.getSize() * on_split_axes(factor);
+        return BoundaryBox(box.getCenter() - size * 0.5f, size);
+    }
+
+    [[nodiscard]] inline DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *child(uint8_t i) noexcept
+    {
+        if (!_nodes[i])
+        {
+            _nodes[i] = _pool->allocate(_rNodes[i], _capacity, _depth - 1, _looseness, _pool, this);
+            touch();
+        }
+
+        return _nodes[i];
+    }
+
+    /**
+     * @brief Pairs within the items of this node when within is set, then between them and the inherited items in
+     * stack from first on. The smaller set is walked and the larger one goes through the SIMD kernel, unless both are
+     * large enough to be swept.
+     */
+    template <typename FUNC>
+    inline void join_node(JoinStack &stack, size_t first, bool within, FUNC &emit) const noexcept
+    {
+        const size_t inherited = stack.size() - first;
+
+        if (within && _items.size() >= SWEEP_THRESHOLD)
+        {
+            std::vector<JoinItem> own = gather();
+            sweep(own, emit);
+        }
+        else if (within)
+        {
+            for (size_t i = 0; i < _items.size(); ++i)
+                overlapping(item_bounds(i), i + 1u, _items.size(), [&](size_t j) { emit(_items[i], _items[j]); });
+        }
+
+        if (inherited >= SWEEP_THRESHOLD && _items.size() >= SWEEP_THRESHOLD)
+        {
+            std::vector<JoinItem> ancestors = gather(stack, first, stack.size());
+            std::vector<JoinItem> own = gather();
+            sweep(ancestors, own, emit);
+        }
+        else if (inherited >= _items.size())
+        {
+            for (size_t j = 0; j < _items.size(); ++j)
+                stack.bounds.overlaps(item_bounds(j), first, stack.size(),
+                                      [&](size_t k) { emit(stack.items[k], _items[j]); });
+        }
+        else
+        {
+            for (size_t k = first; k < stack.size(); ++k)
+                overlapping(stack.bounds[k], 0u, _items.size(), [&](size_t j) { emit(stack.items[k], _items[j]); });
+        }
+    }
+
+    /**
+     * @brief Push the items in stack in [first, last), then the items of this node when own is set, that overlap area.
+     */
+    inline void inherit(JoinStack &stack, size_t first, size_t last, bool own, const BoundaryBox &area) const noexcept
+    {
+        stack.reserve(stack.size() + (last - first) + (own ? _items.size() : 0u)); // no reallocation while visiting
+
+        stack.bounds.overlaps(area, first, last,
+                              [&stack](size_t k) { stack.push_back(stack.bounds[k], stack.items[k]); });
+
+        if (own)
+            overlapping(area, 0u, _items.size(), [&](size_t j) { stack.push_back(item_bounds(j), _items[j]); });
+    }
+
+    /**
+     * @brief Sort and sweep: the boxes are sorted on their min along the axis those are spread the most along, and a
+     * box is only tested against the ones that start before it ends.
+     */
+    template <typename FUNC> static inline void sweep(std::vector<JoinItem> &items, FUNC &emit) noexcept
+    {
+        const uint8_t axis = sweep_axis(items, {});
+        sort_on(items, axis);
+
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            const float end = items[i].itemsize.getMax()[axis];
+
+            for (size_t k = i + 1u; k < items.size() && items[k].itemsize.getMin()[axis] <= end; ++k)
+            {
+                if (items[i].itemsize.overlaps(items[k].itemsize))
+                    emit(items[i].item, items[k].item);
+            }
+        }
+    }
+
+    /**
+     * @brief Sort and sweep between two sets, emit(a, b) with a from the first one and b from the second one.
+     */
+    template <typename FUNC>
+    static inline void sweep(std::vector<JoinItem> &a, std::vector<JoinItem> &b, FUNC &emit) noexcept
+    {
+        const uint8_t axis = sweep_axis(a, b);
+        sort_on(a, axis);
+        sort_on(b, axis);
+
+        for (size_t i = 0, j = 0; i < a.size() && j < b.size();)
+        {
+            if (a[i].itemsize.getMin()[axis] <= b[j].itemsize.getMin()[axis])
+            {
+                const float end = a[i].itemsize.getMax()[axis];
+
+                for (size_t k = j; k < b.size() && b[k].itemsize.getMin()[axis] <= end; ++k)
+                {
+                    if (a[i].itemsize.overlaps(b[k].itemsize))
+                        emit(a[i].item, b[k].item);
+                }
+                ++i;
+            }
+            else
+            {
+                const float end = b[j].itemsize.getMax()[axis];
+
+                for (size_t k = i; k < a.size() && a[k].itemsize.getMin()[axis] <= end; ++k)
+                {
+                    if (a[k].itemsize.overlaps(b[j].itemsize))
+                        emit(a[k].item, b[j].item);
+                }
+                ++j;
+            }
+        }
+    }
+
+    [[nodiscard]] static inline uint8_t sweep_axis(std::span<const JoinItem> a, std::span<const JoinItem> b) noexcept
+    {
+        glm::vec3 low(std::numeric_limits<float>::max());
+        glm::vec3 high(std::numeric_limits<float>::lowest());
+
+        for (const std::span<const JoinItem> &items : {a, b})
+        {
+            for (const JoinItem &item : items)
+            {
+                low = glm::min(low, item.itemsize.getMin());
+                high = glm::max(high, item.itemsize.getMin());
+            }
+        }
+
+        const glm::vec3 spread = high - low;
+        return spread.x >= spread.y ? (spread.x >= spread.z ? 0u : 2u) : (spread.y >= spread.z ? 1u : 2u);
+    }
+
+    static inline void sort_on(std::vector<JoinItem> &items, uint8_t axis) noexcept
+    {
+        std::sort(items.begin(), items.end(), [axis](const JoinItem &lhs, const JoinItem &rhs) {
+            return lhs.itemsize.getMin()[axis] < rhs.itemsize.getMin()[axis];
+        });
+    }
+
+    [[nodiscard]] inline std::vector<JoinItem> gather() const noexcept
+    {
+        std::vector<JoinItem> items;
+        items.reserve(_items.size());
+
+        for (size_t j = 0; j < _items.size(); ++j)
+            items.push_back({item_bounds(j), _items[j]});
+
+        return items;
+    }
+
+    [[nodiscard]] static inline std::vector<JoinItem> gather(const JoinStack &stack, size_t first, size_t last) noexcept
+    {
+        std::vector<JoinItem> items;
+        items.reserve(last - first);
+
+        for (size_t k = first; k < last; ++k)
+            items.push_back({stack.bounds[k], stack.items[k]});
+
+        return items;
+    }
+
+    template <typename FUNC> inline void self_join(JoinStack &stack, size_t first, FUNC &emit) const noexcept
+    {
+        join_node(stack, first, true, emit);
+
+        const size_t last = stack.size();
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            inherit(stack, first, last, true, _rNodes[i]);
+            _nodes[i]->self_join(stack, last, emit);
+            stack.resize(last);
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            for (uint8_t j = i + 1u; j < CHILD_COUNT && _nodes[i]; ++j)
+            {
+                if (_nodes[j] && _rNodes[i].overlaps(_rNodes[j]))
+                    cross_join(stack, i, j, emit);
+            }
+        }
+    }
+
+    /**
+     * @brief Pairs between the inherited items in stack from first on and the whole subtree of this node.
+     */
+    template <typename FUNC> inline void list_join(JoinStack &stack, size_t first, FUNC &emit) const noexcept
+    {
+        join_node(stack, first, false, emit);
+
+        const size_t last = stack.size();
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            inherit(stack, first, last, false, _rNodes[i]);
+            if (stack.size() != last)
+                _nodes[i]->list_join(stack, last, emit);
+            stack.resize(last);
+        }
+    }
+
+    /**
+     * @brief Push every item of the subtree that overlaps area.
+     */
+    inline void collect(JoinStack &stack, const BoundaryBox &area) const noexcept
+    {
+        stack.reserve(stack.size() + _items.size());
+        overlapping(area, 0u, _items.size(), [&](size_t j) { stack.push_back(item_bounds(j), _items[j]); });
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i] && _rNodes[i].overlaps(area))
+                _nodes[i]->collect(stack, area);
+        }
+    }
+
+    /**
+     * @brief Pairs between the subtrees of the children i and j, whose bounds overlap.
+     *
+     * Only the items below one child that overlap the bounds of the other one can pair with anything there, so they
+     * are collected from the smaller subtree and joined with the larger one.
+     */
+    template <typename FUNC>
+    inline void cross_join(JoinStack &stack, uint8_t i, uint8_t j, FUNC &emit) const noexcept
+    {
+        if (_nodes[i]->_count > _nodes[j]->_count)
+            std::swap(i, j);
+
+        const size_t last = stack.size();
+        _nodes[i]->collect(stack, _rNodes[j]);
+
+        if (stack.size() != last)
+            _nodes[j]->list_join(stack, last, emit);
+
+        stack.resize(last);
+    }
+
+    /**
+     * @brief Run the pairs of the top levels of the tree here and turn the subtrees below into independent tasks.
+     */
+    template <typename FUNC>
+    inline void split_join(JoinStack &stack, size_t first, FUNC &emit, std::vector<JoinTask> &tasks,
+                           uint8_t levels) const noexcept
+    {
+        join_node(stack, first, true, emit);
+
+        const size_t last = stack.size();
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            inherit(stack, first, last, true, _rNodes[i]);
+
+            if (levels > 1u && _nodes[i]->_count >= PARALLEL_GRAIN)
+                _nodes[i]->split_join(stack, last, emit, tasks, levels - 1u);
+            else
+                tasks.push_back({_nodes[i], true, slice(stack, last)});
+
+            stack.resize(last);
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            for (uint8_t j = i + 1u; j < CHILD_COUNT && _nodes[i]; ++j)
+            {
+                if (!_nodes[j] || !_rNodes[i].overlaps(_rNodes[j]))
+                    continue;
+
+                const bool smaller = _nodes[i]->_count <= _nodes[j]->_count;
+                _nodes[smaller ? i : j]->collect(stack, _rNodes[smaller ? j : i]);
+
+                if (stack.size() != last)
+                    tasks.push_back({_nodes[smaller ? j : i], false, slice(stack, last)});
+
+                stack.resize(last);
+            }
+        }
+    }
+
+    [[nodiscard]] static inline JoinStack slice(const JoinStack &stack, size_t first)
+    {
+        JoinStack range;
+        range.reserve(stack.size() - first);
+
+        for (size_t k = first; k < stack.size(); ++k)
+            range.push_back(stack.bounds[k], stack.items[k]);
+
+        return range;
+    }
+
+    /**
+     * @brief The value of the item at index, see aggregate().
+     */
+    template <typename FUNC> [[nodiscard]] inline decltype(auto) value_of(FUNC &value, size_t index) const noexcept
+    {
+        if constexpr (std::is_invocable_v<FUNC &, const OBJ_TYPE &, const BoundaryBox &>)
+            return value(_items[index], item_bounds(index));
+        else
+            return value(_items[index]);
+    }
+
+    /**
+     * @brief Position of point along the Morton curve of the tree, made of the octants it falls in at every level.
+     */
+    [[nodiscard]] inline uint32_t curve_key(const glm::vec3 &point) const noexcept
+    {
+        constexpr uint8_t LEVELS = 30u / DIMENSION;
+
+        glm::vec3 min = _boundary.getMin();
+        glm::vec3 size = _boundary.getSize();
+        uint32_t key = 0;
+
+        for (uint8_t level = 0; level < LEVELS; ++level)
+        {
+            size = size * on_split_axes(0.5f);
+            uint32_t i = 0;
+
+            for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+            {
+                const uint8_t axis = SPLIT_AXES[bit];
+
+                if (point[axis] >= min[axis] + size[axis])
+                {
+                    i |= 1u << bit;
+                    min[axis] += size[axis];
+                }
+            }
+
+            key = (key << DIMENSION) | i;
+        }
+
+        return key;
+    }
+
+    /**
+     * @brief Search the queries in active, at most BATCH_GRAIN of them.
+     */
+    template <typename FUNC>
+    inline void search_batch(std::span<const BoundaryBox> areas, std::span<const uint32_t> active,
+                             FUNC &visitor) const noexcept
+    {
+        for (const uint32_t query : active)
+        {
+            OctreeQueryStats::local().visit(_items.size());
+            overlapping(areas[query], 0u, _items.size(), [&](size_t i) { visitor(query, _items[i]); });
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            std::array<uint32_t, BATCH_GRAIN> inside; // queries that hold the whole child
+            std::array<uint32_t, BATCH_GRAIN> partial;
+            size_t insideCount = 0;
+            size_t partialCount = 0;
+
+            for (const uint32_t query : active)
+            {
+                if (!areas[query].overlaps(_rNodes[i]))
+                    continue;
+
+                if (areas[query].contains(_rNodes[i]))
+                    inside[insideCount++] = query;
+                else
+                    partial[partialCount++] = query;
+            }
+
+            // the items of the child are taken without a test, in one walk for all the queries that hold it
+            if (insideCount != 0)
+            {
+                _nodes[i]->items([&](const OBJ_TYPE &item) {
+                    for (size_t k = 0; k < insideCount; ++k)
+                        visitor(inside[k], item);
+                });
+            }
+
+            if (partialCount != 0)
+                _nodes[i]->search_batch(areas, std::span<const uint32_t>(partial.data(), partialCount), visitor);
+        }
+    }
+
+    template <typename VALUE, typename FUNC, typename COMBINE>
+    [[nodiscard]] inline VALUE aggregate(const BoundaryBox &rArea, OctreeAggregate<VALUE> &cache, FUNC &value,
+                                         COMBINE &combine, uint32_t epoch) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+
+        VALUE total = cache._identity;
+        overlapping(rArea, 0u, _items.size(), [&](size_t i) { total = combine(total, value_of(value, i)); });
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            if (rArea.contains(_rNodes[i]))
+                total = combine(total, _nodes[i]->total(cache, value, combine, epoch));
+            else if (rArea.overlaps(_rNodes[i]))
+                total = combine(total, _nodes[i]->aggregate(rArea, cache, value, combine, epoch));
+        }
+
+        return total;
+    }
+
+    /**
+     * @brief Total of the whole subtree, from cache unless this node changed after it was taken.
+     */
+    template <typename VALUE, typename FUNC, typename COMBINE>
+    [[nodiscard]] inline VALUE total(OctreeAggregate<VALUE> &cache, FUNC &value, COMBINE &combine,
+                                     uint32_t epoch) const noexcept
+    {
+        // a change marks the ancestors too, so an unchanged node has an unchanged subtree
+        if (const auto it = cache._totals.find(this); it != cache._totals.end() && _changed <= it->second.epoch)
+            return it->second.value;
+
+        VALUE sum = cache._identity;
+
+        for (size_t i = 0; i < _items.size(); ++i)
+            sum = combine(sum, value_of(value, i));
+
+        for (const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node : _nodes)
+        {
+            if (node)
+                sum = combine(sum, node->total(cache, value, combine, epoch));
+        }
+
+        cache._totals.insert_or_assign(this, typename OctreeAggregate<VALUE>::Total{sum, epoch});
+        return sum;
+    }
+
+    /**
+     * @param theta2 the opening angle, squared.
+     */
+    template <typename FUNC, typename COMBINE, typename NEAR, typename FAR>
+    inline void approximate_visit(const glm::vec3 &point, float theta2, OctreeAggregate<OctreeMass> &cache,
+                                  FUNC &value, COMBINE &combine, NEAR &visitor, FAR &far,
+                                  uint32_t epoch) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+
+        for (const OBJ_TYPE &item : _items)
+            visitor(item);
+
+        for (const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node : _nodes)
+        {
+            if (!node)
+                continue;
+
+            const OctreeMass summary = node->total(cache, value, combine, epoch);
+            const BoundaryBox bounds = summary.bounds();
+            const glm::vec3 size = bounds.getSize();
+            const glm::vec3 offset = summary.centre() - point;
+            const float side = std::max({size.x, size.y, size.z});
+
+            if (!bounds.contains(point) && side * side < theta2 * glm::dot(offset, offset))
+                far(summary);
+            else
+                node->approximate_visit(point, theta2, cache, value, combine, visitor, far, epoch);
+        }
+    }
+
+    template <typename FUNC>
+    inline void search(const Frustum &frustum, FUNC &visitor, uint8_t mask) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+        for (size_t i = 0; i < _items.size(); ++i)
+        {
+            if (frustum.classify(_bounds[i], mask) != Frustum::OUTSIDE && refine(frustum, i))
+                visitor(_items[i]);
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            const uint8_t childMask = frustum.classify(_rNodes[i], mask);
+
+            if (childMask == 0u)
+                _nodes[i]->items(visitor);
+            else if (childMask != Frustum::OUTSIDE)
+                _nodes[i]->search(frustum, visitor, childMask);
+        }
+    }
+
+    inline void extract(std::vector<OctreeBulkItem<OBJ_TYPE>> &items) const
+    {
+        for (size_t i = 0; i < _items.size(); ++i)
+            items.push_back({_items[i], item_bounds(i)});
+
+        for (const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node : _nodes)
+        {
+            if (node)
+                node->extract(items);
+        }
+    }
+
+    inline void stats(OctreeStats &shape, size_t depth) const noexcept
+    {
+        if (shape.nodesPerDepth.size() <= depth)
+        {
+            shape.nodesPerDepth.resize(depth + 1u);
+            shape.itemsPerDepth.resize(depth + 1u);
+        }
+
+        ++shape.nodes;
+        ++shape.nodesPerDepth[depth];
+        shape.items += _items.size();
+        shape.itemsPerDepth[depth] += _items.size();
+        shape.maxItemsPerNode = std::max(shape.maxItemsPerNode, _items.size());
+        shape.itemBytes += _items.capacity() * sizeof(OBJ_TYPE) + _bounds.bytes();
+
+        if (_split)
+            shape.internalItems += _items.size();
+
+        for (const DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node : _nodes)
+        {
+            if (node)
+                node->stats(shape, depth + 1u);
+        }
+    }
+
+    template <typename AREA, typename FUNC>
+    inline void search_changes(const AREA &previous, const AREA &rArea, uint32_t since, bool moved,
+                               FUNC &visitor) const noexcept
+    {
+        if (_changed <= since && !moved)
+            return;
+
+        OctreeQueryStats::local().visit(_items.size());
+
+        if (_changed > since)
+        {
+            for (uint32_t i = 0; i < _items.size(); ++i)
+                visitor(_items[i], rArea.overlaps(_bounds[i]) && refine(rArea, i));
+        }
+        else
+        {
+            for (uint32_t i = 0; i < _items.size(); ++i)
+            {
+                BoundaryBox itemsize = _bounds[i];
+                bool inside = rArea.overlaps(itemsize);
+                bool before = previous.overlaps(itemsize);
+
+                // the stored bounds of a quantized node may overlap an area the item is out of, so both are redone
+                if constexpr (QUANTIZED)
+                {
+                    if (inside || before)
+                    {
+                        itemsize = item_bounds(i);
+                        inside = rArea.overlaps(itemsize);
+                        before = previous.overlaps(itemsize);
+                    }
+                }
+
+                if (inside != before)
+                    visitor(_items[i], inside);
+            }
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i] || (!previous.overlaps(_rNodes[i]) && !rArea.overlaps(_rNodes[i])))
+                continue;
+
+            // none of the unchanged items below can have crossed a border that is not in their bounds
+            if (_nodes[i]->_changed > since || !(previous.contains(_rNodes[i]) && rArea.contains(_rNodes[i])))
+                _nodes[i]->search_changes(previous, rArea, since, moved, visitor);
+        }
+    }
+
+    template <typename FUNC>
+    inline void raycast(const glm::vec3 &origin, const glm::vec3 &inverseDirection, float &tmax, FUNC &hit,
+                        std::optional<OctreeRayHit<OBJ_TYPE>> &closest) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+        for (size_t i = 0; i < _items.size(); ++i)
+        {
+            const float entry = item_entry(i, origin, inverseDirection, tmax);
+
+            if (entry < 0.f)
+                continue;
+
+            if (const float distance = hit(_items[i], entry); distance < tmax)
+            {
+                tmax = distance;
+                closest = OctreeRayHit<OBJ_TYPE>{_items[i], distance};
+            }
+        }
+
+        std::array<std::pair<float, uint8_t>, CHILD_COUNT> order;
+        size_t count = 0;
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (!_nodes[i])
+                continue;
+
+            if (const float entry = _rNodes[i].rayEntry(origin, inverseDirection, tmax); entry >= 0.f)
+                order[count++] = {entry, i};
+        }
+
+        std::sort(order.begin(), order.begin() + count);
+
+        for (size_t k = 0; k < count && order[k].first <= tmax; ++k)
+            _nodes[order[k].second]->raycast(origin, inverseDirection, tmax, hit, closest);
+    }
+
+    template <typename FUNC>
+    [[nodiscard]] inline bool raycast_any(const glm::vec3 &origin, const glm::vec3 &inverseDirection, float tmax,
+                                          FUNC &hit) const noexcept
+    {
+        OctreeQueryStats::local().visit(_items.size());
+        for (size_t i = 0; i < _items.size(); ++i)
+        {
+            const float entry = item_entry(i, origin, inverseDirection, tmax);
+
+            if (entry >= 0.f && hit(_items[i], entry) < tmax)
+                return true;
+        }
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i] && _rNodes[i].rayEntry(origin, inverseDirection, tmax) >= 0.f &&
+                _nodes[i]->raycast_any(origin, inverseDirection, tmax, hit))
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Fill this empty node and its subtree, scratch is a buffer of the same size used for the scatter.
+     */
+    template <typename RELINK>
+    inline void build(std::span<OctreeBulkItem<OBJ_TYPE>> items, std::span<OctreeBulkItem<OBJ_TYPE>> scratch,
+                      ThreadPool *threadPool, RELINK &relink) noexcept
+    {
+        _count = static_cast<uint32_t>(items.size());
+
+        if (_depth == 0 || items.size() <= _capacity)
+            return store(items, relink);
+
+        _split = true;
+
+        std::array<size_t, CHILD_COUNT + 2u> offsets{};
+        for (OctreeBulkItem<OBJ_TYPE> &entry : items)
+        {
+            const uint8_t i = octant(entry.itemsize.getCenter());
+            entry.bucket = _rNodes[i].contains(entry.itemsize) ? i : CHILD_COUNT;
+            ++offsets[entry.bucket + 1u];
+        }
+
+        for (uint8_t i = 1; i < offsets.size(); ++i)
+            offsets[i] += offsets[i - 1u];
+
+        std::array<size_t, CHILD_COUNT + 2u> next = offsets;
+        for (OctreeBulkItem<OBJ_TYPE> &entry : items)
+            scratch[next[entry.bucket]++] = std::move(entry);
+
+        store(scratch.subspan(offsets[CHILD_COUNT], offsets[CHILD_COUNT + 1u] - offsets[CHILD_COUNT]), relink);
+
+        // the children are built out of scratch, with the matching range of items as their own scratch
+        const auto run = [&](uint8_t i) { return scratch.subspan(offsets[i], offsets[i + 1u] - offsets[i]); };
+        const auto spare = [&](uint8_t i) { return items.subspan(offsets[i], offsets[i + 1u] - offsets[i]); };
+
+        if (!threadPool || items.size() < PARALLEL_GRAIN)
+        {
+            for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+            {
+                if (!run(i).empty())
+                    child(i)->build(run(i), spare(i), nullptr, relink);
+            }
+            return;
+        }
+
+        std::array<uint8_t, CHILD_COUNT> octants{};
+        std::array<std::unique_ptr<Pool>, CHILD_COUNT> pools{};
+        size_t count = 0;
+
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (run(i).empty())
+                continue;
+
+            octants[count] = i;
+            pools[count] = std::make_unique<Pool>();
+            child(i)->_pool = pools[count++].get();
+        }
+
+        threadPool->parallel_for(count, [&](size_t k) {
+            _nodes[octants[k]]->build(run(octants[k]), spare(octants[k]), threadPool, relink);
+        });
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            _pool->adopt(*pools[k]);
+            _nodes[octants[k]]->repoint(_pool);
+        }
+    }
+
+    template <typename RELINK> inline void store(std::span<OctreeBulkItem<OBJ_TYPE>> items, RELINK &relink) noexcept
+    {
+        _items.reserve(_items.size() + items.size());
+        _bounds.reserve(_bounds.size() + items.size());
+        touch();
+
+        for (const OctreeBulkItem<OBJ_TYPE> &entry : items)
+        {
+            _items.emplace_back(entry.item);
+            _bounds.push_back(entry.itemsize);
+            relink(_items.back(), OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>{
+                                      this, static_cast<uint32_t>(_items.size() - 1u)});
+        }
+    }
+
+    inline void repoint(Pool *pool) noexcept
+    {
+        _pool = pool;
+
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node : _nodes)
+        {
+            if (node)
+                node->repoint(pool);
+        }
+    }
+
+    /**
+     * @brief Swap-and-pop the item at index out of this node, without touching the subtree counters.
+     */
+    template <typename RELINK> inline void erase(uint32_t index, RELINK &relink) noexcept
+    {
+        const uint32_t last = static_cast<uint32_t>(_items.size() - 1u);
+
+        _bounds.swap_pop(index);
+        touch();
+
+        if (index != last)
+        {
+            _items[index] = std::move(_items[last]);
+            relink(_items[index], OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>{this, index});
+        }
+
+        _items.pop_back();
+    }
+
+    /**
+     * @brief Turn a leaf into an internal node and push its items down into the children that can hold them.
+     */
+    template <typename RELINK> inline void split(RELINK &relink) noexcept
+    {
+        _split = true;
+
+        for (uint32_t index = static_cast<uint32_t>(_items.size()); index-- > 0;)
+        {
+            const BoundaryBox itemsize = item_bounds(index);
+            const uint8_t i = octant(itemsize.getCenter());
+
+            if (!_rNodes[i].contains(itemsize))
+                continue;
 
-template <typename OBJ_TYPE> class DynamicOctree {
-private:
-    enum class INDEX : uint8_t {
-        SWD, // South-West-Down (min corner)
-        SED, // South-East-Down
-        NWD, // North-West-Down
-        NED, // North-East-Down
-        SWU, // South-West-Up
-        SEU, // South-East-Up
-        NWU, // North-West-Up
-        NEU  // North-East-Up (max corner)
-    };
+            OBJ_TYPE item = std::move(_items[index]);
+            erase(index, relink);
+            relink(item, child(i)->insert(item, itemsize, relink));
+        }
+    }
 
-public:
-    DynamicOctree(const BoundaryBox &boundary, const uint8_t capacity = MAX_CAPACITY,
-                  const uint8_t depth = MAX_DEPTH) noexcept
-        : _boundary(boundary), _DEPTH(depth), _CAPACITY(capacity)
+    /**
+     * @brief Update the subtree counters after one item left this node, then merge or drop the subtree that became
+     * too small.
+     */
+    template <typename RELINK> inline void shrink(RELINK &relink) noexcept
     {
-        resize(boundary);
+        discount(1u);
+
+        if (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = shrink_target())
+            node->reduce(relink);
     }
-    ~DynamicOctree() = default;
 
-    inline void resize(const BoundaryBox &rArea) noexcept
+    inline void discount(uint32_t removed) noexcept
     {
-        if (_boundary == rArea)
-            return;
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = this; node; node = node->_parent)
+            node->_count -= removed;
+    }
 
-        clear();
-        _boundary = rArea;
+    /**
+     * @brief Find the node of this branch that should be reduced after some removals.
+     *
+     * The highest empty node is given back to the pool. Otherwise the highest ancestor whose subtree fell to half the
+     * capacity takes back all the items of its children.
+     */
+    [[nodiscard]] inline DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *shrink_target() noexcept
+    {
+        DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *merge = nullptr;
+        DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *empty = nullptr;
 
-        glm::vec3 size = _boundary.getSize() * 0.5f;
-        glm::vec3 pos = _boundary.getMin();
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = this; node; node = node->_parent)
+        {
+            if (node->_split && node->_count <= node->_capacity / 2u)
+                merge = node;
+            if (node->_count == 0 && node->_parent)
+                empty = node;
+        }
 
-        _rNodes[static_cast<size_t>(INDEX::SWD)] = BoundaryBox(pos, size);
-        _rNodes[static_cast<size_t>(INDEX::SED)] = BoundaryBox({pos.x + size.x, pos.y, pos.z}, size);
-        _rNodes[static_cast<size_t>(INDEX::NWD)] = BoundaryBox({pos.x, pos.y + size.y, pos.z}, size);
-        _rNodes[static_cast<size_t>(INDEX::NED)] = BoundaryBox({pos.x + size.x, pos.y + size.y, pos.z}, size);
-        _rNodes[static_cast<size_t>(INDEX::SWU)] = BoundaryBox({pos.x, pos.y, pos.z + size.z}, size);
-        _rNodes[static_cast<size_t>(INDEX::SEU)] = BoundaryBox({pos.x + size.x, pos.y, pos.z + size.z}, size);
-        _rNodes[static_cast<size_t>(INDEX::NWU)] = BoundaryBox({pos.x, pos.y + size.y, pos.z + size.z}, size);
-        _rNodes[static_cast<size_t>(INDEX::NEU)] = BoundaryBox(pos + size, size);
+        return (empty && (!merge || merge->_count == 0)) ? empty : merge;
     }
 
-    inline void clear() noexcept
+    template <typename RELINK> inline void reduce(RELINK &relink) noexcept
     {
-        _pItems.clear();
+        if (_count == 0 && _parent)
+            _parent->release(this);
+        else
+            collapse(relink);
+    }
 
-        for (uint8_t i = 0; i < 8u; ++i)
+    /**
+     * @brief Move every item of the subtree into this node and give the child nodes back to the pool.
+     */
+    template <typename RELINK> inline void collapse(RELINK &relink) noexcept
+    {
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
         {
             if (_nodes[i])
-                _nodes[i]->clear();
+                adopt(*_nodes[i], relink);
+        }
 
-            _nodes[i].reset();
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (_nodes[i])
+                release(_nodes[i]);
         }
 
-        _rNodes.fill(BoundaryBox());
-        _boundary = BoundaryBox();
+        _split = false;
     }
 
-    [[nodiscard, deprecated("Use DynamicOctreeContainer::size() instead.")]] inline size_t size() const noexcept
+    template <typename RELINK>
+    inline void adopt(DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> &node, RELINK &relink) noexcept
     {
-        size_t size = _pItems.size();
+        touch();
 
-        for (uint8_t i = 0; i < 8u; ++i)
+        for (uint32_t index = 0; index < node._items.size(); ++index)
         {
-            if (_nodes[i])
-                size += _nodes[i]->size();
+            _items.emplace_back(std::move(node._items[index]));
+            _bounds.push_back(node.item_bounds(index));
+            relink(_items.back(), OctreeItemLocation<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>{
+                                      this, static_cast<uint32_t>(_items.size() - 1u)});
         }
 
-        return size;
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
+        {
+            if (node._nodes[i])
+                adopt(*node._nodes[i], relink);
+        }
     }
 
-    [[nodiscard]] inline OctreeItemLocation<OBJ_TYPE> insert(const OBJ_TYPE &item, const BoundaryBox &itemsize) noexcept
+    /**
+     * @brief Empty the root and give it another boundary and depth, the nodes it held stay in the arena for the
+     * caller to link again.
+     */
+    inline void reset_root(const BoundaryBox &boundary, uint8_t depth) noexcept
     {
-        for (uint8_t i = 0; i < 8u; ++i)
-        {
-            if (_DEPTH == 0 || _pItems.size() < _CAPACITY)
-                break;
+        _items.clear();
+        _bounds.clear();
+        _nodes.fill(nullptr);
+        _count = 0;
+        _split = false;
 
-            else if (!_rNodes[i].contains(itemsize))
-                continue;
+        _boundary = boundary;
+        _depth = depth;
+        set_child_bounds(_boundary);
 
-            if (!_nodes[i])
-                _nodes[i] = std::make_unique<DynamicOctree<OBJ_TYPE>>(_rNodes[i], _CAPACITY, _DEPTH - 1);
+        if constexpr (QUANTIZED)
+            _bounds.frame(_boundary, true);
+    }
+
+    /**
+     * @brief One step of grow_to_include(): the root becomes the child index of a root with the given boundary.
+     */
+    template <typename RELINK> inline void grow(const BoundaryBox &boundary, uint8_t index, RELINK &relink) noexcept
+    {
+        std::vector<OctreeBulkItem<OBJ_TYPE>> items;
+        items.reserve(_items.size());
+        for (size_t i = 0; i < _items.size(); ++i)
+            items.push_back({_items[i], item_bounds(i)});
+
+        const BoundaryBox tight = _boundary;
+        const std::array<BoundaryBox, CHILD_COUNT> rNodes = _rNodes;
+        const std::array<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *, CHILD_COUNT> nodes = _nodes;
+        const uint32_t count = _count - static_cast<uint32_t>(_items.size());
+        const bool split = _split;
+
+        reset_root(boundary, static_cast<uint8_t>(_depth + 1u));
+
+        if (std::find_if(nodes.begin(), nodes.end(), [](const auto *node) { return node; }) != nodes.end())
+        {
+            DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node =
+                _pool->allocate(scale(tight, _looseness), _capacity, _depth - 1, _looseness, _pool, this);
 
-            return _nodes[i]->insert(item, itemsize);
+            node->_rNodes = rNodes; // scaling the bounds back and forth would not give the very same children
+            node->_nodes = nodes;
+            node->_count = count;
+            node->_split = split;
+            for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *child : nodes)
+            {
+                if (child)
+                    child->_parent = node;
+            }
+
+            _rNodes[index] = node->_boundary;
+            _nodes[index] = node;
+            _count = count;
+            _split = true;
         }
 
-        _pItems.emplace_back(itemsize, item);
-        return {&_pItems, std::prev(_pItems.end())};
+        touch();
+        for (const OctreeBulkItem<OBJ_TYPE> &entry : items)
+            relink(entry.item, insert(entry.item, entry.itemsize, relink));
     }
 
-    [[nodiscard]] inline std::list<OBJ_TYPE> search(const BoundaryBox &rArea) const noexcept
+    /**
+     * @brief One step of shrink_to_fit(): node, the only child of the root, becomes the root.
+     */
+    template <typename RELINK>
+    inline void shrink(DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node, RELINK &relink) noexcept
     {
-        std::list<OBJ_TYPE> listItems;
-        search(rArea, listItems);
-        return listItems;
+        std::vector<OctreeBulkItem<OBJ_TYPE>> items;
+        items.reserve(node->_items.size());
+        for (size_t i = 0; i < node->_items.size(); ++i)
+            items.push_back({node->_items[i], node->item_bounds(i)});
+
+        const BoundaryBox tight = scale(node->_boundary, 1.f / _looseness);
+        const std::array<BoundaryBox, CHILD_COUNT> rNodes = node->_rNodes;
+        const std::array<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *, CHILD_COUNT> nodes = node->_nodes;
+        const uint32_t count = node->_count - static_cast<uint32_t>(node->_items.size());
+        const uint8_t depth = node->_depth;
+        const bool split = node->_split;
+
+        _pool->deallocate(node);
+        reset_root(tight, depth);
+
+        _rNodes = rNodes;
+        _nodes = nodes;
+        _count = count;
+        _split = split;
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *child : _nodes)
+        {
+            if (child)
+                child->_parent = this;
+        }
+
+        touch();
+        for (const OctreeBulkItem<OBJ_TYPE> &entry : items)
+            relink(entry.item, insert(entry.item, entry.itemsize, relink));
     }
 
-    inline void search(const BoundaryBox &rArea, std::list<OBJ_TYPE> &listItems) const noexcept
+    /**
+     * @brief Give a child and its whole subtree back to the pool.
+     */
+    inline void release(DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node) noexcept
     {
-        for (const auto &[rItem, item] : _pItems)
+        for (uint8_t i = 0; i < CHILD_COUNT; ++i)
         {
-            if (rArea.overlaps(rItem))
-                listItems.emplace_back(item);
+            if (node->_nodes[i])
+                node->release(node->_nodes[i]);
         }
 
-        for (uint8_t i = 0; i < 8u; ++i)
-        {
-            if (!_nodes[i])
-                continue;
+        _nodes[std::find(_nodes.begin(), _nodes.end(), node) - _nodes.begin()] = nullptr;
+        _pool->deallocate(node);
+        touch();
+    }
 
-            if (rArea.contains(_rNodes[i]))
-                _nodes[i]->items(listItems);
-            else if (rArea.overlaps(_rNodes[i]))
-                _nodes[i]->search(rArea, listItems);
+    /**
+     * @brief Mark this node and its ancestors as changed since the last snapshot and in the current epoch.
+     *
+     * The ancestors of a marked node are always marked too, so the walk stops at the first one that already is.
+     */
+    inline void touch() noexcept
+    {
+        for (DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *node = this;
+             node && (!node->_dirty || node->_changed != *_clock); node = node->_parent)
+        {
+            node->_dirty = true;
+            node->_changed = *_clock;
         }
     }
 
-    inline void items(std::list<OBJ_TYPE> &listItems) const noexcept
+    /**
+     * @brief Index of the child whose tight bounds hold point, the children share the center of their parent.
+     */
+    [[nodiscard]] inline uint8_t octant(const glm::vec3 &point) const noexcept
     {
-        for (const auto &[rItem, item] : _pItems)
-            listItems.emplace_back(item);
+        const glm::vec3 center = _boundary.getCenter();
+        uint8_t i = 0;
 
-        for (uint8_t i = 0; i < 8u; ++i)
-        {
-            if (_nodes[i])
-                _nodes[i]->items(listItems);
-        }
+        for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+            i |= static_cast<uint8_t>((point[SPLIT_AXES[bit]] >= center[SPLIT_AXES[bit]]) << bit);
+
+        return i;
     }
 
-    [[nodiscard]] inline const BoundaryBox &boundary() const noexcept { return _boundary; }
+    /**
+     * @brief factor along the split axes and 1 along the others.
+     */
+    [[nodiscard]] static inline glm::vec3 on_split_axes(float factor) noexcept
+    {
+        glm::vec3 scale(1.f);
+
+        for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+            scale[SPLIT_AXES[bit]] = factor;
 
-    [[nodiscard]] inline bool remove(OBJ_TYPE pItem) noexcept
+        return scale;
+    }
+
+    /**
+     * @brief Bounds of the item at index, exact when a quantized tree was given them through refine_with().
+     */
+    [[nodiscard]] inline BoundaryBox item_bounds(size_t index) const noexcept
     {
-        auto it = std::find_if(_pItems.begin(), _pItems.end(),
-                               [pItem](const std::pair<BoundaryBox, OBJ_TYPE> &p) { return p.second == pItem; });
+        if constexpr (QUANTIZED)
+        {
+            if (*_exact)
+                return (*_exact)(_items[index]);
+        }
+        return _bounds[index];
+    }
 
-        if (it != _pItems.end())
+    /**
+     * @brief Whether an item the stored bounds put in area really is in it, always true when those are exact.
+     */
+    template <typename AREA> [[nodiscard]] inline bool refine(const AREA &area, size_t index) const noexcept
+    {
+        if constexpr (QUANTIZED)
         {
-            _pItems->erase(it);
-            return true;
+            if (*_exact)
+                return area.overlaps((*_exact)(_items[index]));
         }
+        return true;
+    }
 
-        for (uint8_t i = 0; i < 8u; ++i)
+    /**
+     * @brief Call visitor(index) for the items in [first, last) that overlap area, the stored bounds of a quantized
+     * node are only refined for the items they cannot tell about.
+     */
+    template <typename FUNC>
+    inline void overlapping(const BoundaryBox &area, size_t first, size_t last, FUNC &&visitor) const noexcept
+    {
+        if constexpr (QUANTIZED)
         {
-            if (_nodes[i] && _nodes[i]->remove(pItem))
-                return true;
+            _bounds.overlaps(area, first, last, [this, &area, &visitor](size_t index, bool inside) {
+                if (inside || refine(area, index))
+                    visitor(index);
+            });
         }
+        else
+            _bounds.overlaps(area, first, last, visitor);
+    }
 
-        return false;
+    /**
+     * @brief Distance at which the ray enters the bounds of the item at index, negative when it misses them.
+     */
+    [[nodiscard]] inline float item_entry(size_t index, const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                                          float tmax) const noexcept
+    {
+        const float entry = _bounds[index].rayEntry(origin, inverseDirection, tmax);
+
+        if constexpr (QUANTIZED)
+        {
+            if (entry >= 0.f && *_exact)
+                return (*_exact)(_items[index]).rayEntry(origin, inverseDirection, tmax);
+        }
+        return entry;
     }
 
-#ifdef DEBUG
-    inline void draw(sf::RenderWindow &window, const BoundaryBox &rArea) const noexcept
+    /**
+     * @brief Compute the bounds of the children from the tight bounds of this node, one unrolled step per child.
+     */
+    inline void set_child_bounds(const BoundaryBox &tight) noexcept
     {
-        sf::RectangleShape rectangle;
-        rectangle.setPosition({rArea.getMin().x, rArea.getMin().y});
-        rectangle.setSize({rArea.getMax().x - rArea.getMin().x, rArea.getMax().y - rArea.getMin().y});
-        rectangle.setFillColor(sf::Color::Transparent);
-        rectangle.setOutlineColor(sf::Color::Green);
-        rectangle.setOutlineThickness(1);
-        window.draw(rectangle);
+        const glm::vec3 size = tight.getSize() * on_split_axes(0.5f);
+        const glm::vec3 pos = tight.getMin();
 
-        for (uint8_t i = 0; i < 8u; ++i)
+        [&]<uint8_t... I>(std::integer_sequence<uint8_t, I...>) {
+            ((_rNodes[I] = BoundaryBox(pos + size * glm::vec3(CHILD_OFFSETS[I][0], CHILD_OFFSETS[I][1],
+                                                              CHILD_OFFSETS[I][2]),
+                                       size)),
+             ...);
+        }(std::make_integer_sequence<uint8_t, CHILD_COUNT>{});
+
+        if (_looseness != TIGHT_LOOSENESS)
         {
-            if (_nodes[i])
-                _nodes[i]->draw(window, rArea);
+            for (BoundaryBox &rNode : _rNodes)
+                rNode = scale(rNode, _looseness);
         }
     }
-#endif
 
 protected:
-    const uint8_t _DEPTH = 1;
-    const uint8_t _CAPACITY = 4;
+    uint8_t _depth = 1; // the parameters only change on the root, see rebuild() and grow_to_include()
+    uint8_t _capacity = 4;
+    float _looseness = TIGHT_LOOSENESS;
 
     BoundaryBox _boundary{};
 
-    std::array<BoundaryBox, 8u> _rNodes{};
+    std::array<BoundaryBox, CHILD_COUNT> _rNodes{};
+
+    std::array<DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *, CHILD_COUNT> _nodes{};
+
+    std::unique_ptr<Pool> _arena; // only set on the root, owns every node of the tree
+    Pool *_pool = nullptr;
+    DynamicOctree<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK> *_parent = nullptr;
+    const uint32_t *_clock = nullptr; // epoch of the whole tree, held by the root
+    // exact bounds of the items of a quantized tree, owned by the root and read by every node through _exact
+    [[no_unique_address]] std::conditional_t<QUANTIZED, std::unique_ptr<Refine>, Unused<0>> _refine{};
+    [[no_unique_address]] std::conditional_t<QUANTIZED, const Refine *, Unused<1>> _exact{};
 
-    std::array<std::unique_ptr<DynamicOctree<OBJ_TYPE>>, 8u> _nodes{};
+    uint32_t _count = 0;   // items in the whole subtree
+    uint32_t _epoch = 0;   // only used on the root, see stamp()
+    uint32_t _changed = 0; // last epoch in which the subtree changed
+    bool _split = false;   // new items go down into the children once set
+    bool _dirty = true;    // changed since the last snapshot, new nodes have never been copied
 
-    std::list<std::pair<BoundaryBox, OBJ_TYPE>> _pItems{};
+    std::vector<OBJ_TYPE> _items{};
+    BOUNDS_BLOCK _bounds{}; // bounds of _items, same order
 };
 
-template <typename OBJ_TYPE> struct OctreeItem {
+template <typename OBJ_TYPE, uint8_t DIMENSION = 3u, typename BOUNDS_BLOCK = BoundaryBoxBlock> struct OctreeItem {
     OBJ_TYPE item;
-    OctreeItemLocation<typename std::list<OctreeItem<OBJ_TYPE>>::iterator> pItem;
+    OctreeItemLocation<uint32_t, DIMENSION, BOUNDS_BLOCK> pItem; // the octree holds the slot of the item
 };
 
-template <typename OBJ_TYPE> class DynamicOctreeContainer {
+/**
+ * @brief Octree that owns its items.
+ *
+ * The items are kept together in a SlotMap and the nodes only hold their 32-bit slot, the searches hand out a Handle
+ * that stays valid until the item is removed and that operator[] turns back into the item.
+ *
+ * With a QuantizedBoundaryBoxBlock as BOUNDS_BLOCK the nodes store the bounds of the items in a few bytes, see
+ * refine_with().
+ */
+template <typename OBJ_TYPE, uint8_t DIMENSION = 3u, typename BOUNDS_BLOCK = BoundaryBoxBlock>
+class DynamicOctreeContainer {
+public:
+    using OctreeContainer = SlotMap<OctreeItem<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>>;
+    using Handle = SlotHandle;
+    using Snapshot = OctreeSnapshot<OBJ_TYPE, DIMENSION>;
+    using Location = OctreeItemLocation<uint32_t, DIMENSION, BOUNDS_BLOCK>;
+    using Tree = DynamicOctree<uint32_t, DIMENSION, BOUNDS_BLOCK>;
+
+private:
+    /**
+     * @brief Items found by the last search of a Query, the container reports to it the ones it moves or removes.
+     */
+    struct Found {
+        const OctreeContainer *store = nullptr; // of the container that the query follows
+        std::unordered_set<uint32_t> items;     // slots
+        std::unordered_set<uint32_t> moved;     // to another node, checked again
+        std::vector<OBJ_TYPE> removed;          // left the container, not reported yet
+    };
+
 public:
-    using OctreeContainer = std::list<OctreeItem<OBJ_TYPE>>;
+    /**
+     * @brief Handle of a search repeated over time, like the view of a camera every frame, that keeps what it found.
+     *
+     * search(query, area, enter, exit) only reports the items that entered or left area since the previous search
+     * with the same handle. A handle follows a single container.
+     */
+    template <typename AREA = BoundaryBox>
+        requires std::same_as<AREA, BoundaryBox> || std::same_as<AREA, Frustum>
+    class Query {
+    public:
+        /**
+         * @brief Items that overlapped the area at the last search.
+         */
+        [[nodiscard]] inline size_t size() const noexcept { return _found ? _found->items.size() : 0u; }
+
+        template <typename FUNC>
+            requires std::invocable<FUNC &, const OBJ_TYPE &>
+        inline void items(FUNC &&visitor) const noexcept
+        {
+            if (!_found)
+                return;
+
+            for (const uint32_t slot : _found->items)
+                visitor(_found->store->at(slot).item);
+        }
+
+    private:
+        friend DynamicOctreeContainer;
+
+        AREA _area{};
+        uint32_t _since = 0;           // epoch of the tree at the last search
+        std::shared_ptr<Found> _found; // the container only holds it weakly
+    };
 
 public:
     DynamicOctreeContainer(const BoundaryBox &size, const uint8_t capacity = MAX_CAPACITY,
-                           const uint8_t depth = MAX_DEPTH) noexcept
-        : _root(size, capacity, depth)
+                           const uint8_t depth = MAX_DEPTH, const float looseness = TIGHT_LOOSENESS) noexcept
+        : _root(size, capacity, depth, looseness)
     {
     }
     ~DynamicOctreeContainer() = default;
 
-    inline void resize(const BoundaryBox &rArea) noexcept { _root.resize(rArea); }
+    inline void resize(const BoundaryBox &rArea) noexcept
+    {
+        if (!(_root.boundary() == rArea))
+            leave_all();
+
+        _root.resize(rArea);
+    }
+
+    /**
+     * @brief Grow the octree until it holds rArea, keeping its nodes, see DynamicOctree::grow_to_include().
+     */
+    inline void grow_to_include(const BoundaryBox &rArea) noexcept
+    {
+        _root.grow_to_include(rArea, Relink{_allItems});
+    }
+
+    /**
+     * @brief Drop the top levels of the octree that hold everything in a single child, see
+     * DynamicOctree::shrink_to_fit().
+     */
+    inline void shrink_to_fit() noexcept { _root.shrink_to_fit(Relink{_allItems}); }
+
+    /**
+     * @brief Build the octree again with other node parameters, the items and the queries on them are kept.
+     */
+    inline void reconfigure(const uint8_t capacity, const uint8_t depth, const float looseness = TIGHT_LOOSENESS,
+                            ThreadPool *threadPool = nullptr) noexcept
+    {
+        _root.rebuild(capacity, depth, looseness, threadPool, Relink{_allItems});
+    }
+
+    [[nodiscard]] inline uint8_t capacity() const noexcept { return _root.capacity(); }
+    [[nodiscard]] inline uint8_t depth() const noexcept { return _root.depth(); }
+    [[nodiscard]] inline float looseness() const noexcept { return _root.looseness(); }
 
     [[nodiscard]] inline size_t size() const noexcept { return _allItems.size(); }
 
@@ -261,52 +2628,468 @@ public:
 
     inline void clear() noexcept
     {
+        leave_all();
         _root.clear();
         _allItems.clear();
     }
 
     [[nodiscard]] inline const BoundaryBox &boundary() const noexcept { return _root.boundary(); }
 
+    /**
+     * @brief Exact bounds of the items for a quantized tree, see DynamicOctree::refine_with().
+     */
+    inline void refine_with(std::function<BoundaryBox(const OBJ_TYPE &)> exact) noexcept
+        requires Tree::QUANTIZED
+    {
+        _root.refine_with([this, exact = std::move(exact)](uint32_t slot) { return exact(_allItems.at(slot).item); });
+    }
+
+    /**
+     * @brief Shape and memory of the octree, see DynamicOctree::stats(). The slot map of the items is added to
+     * itemBytes.
+     */
+    [[nodiscard]] inline OctreeStats stats() const noexcept
+    {
+        OctreeStats shape = _root.stats();
+        shape.itemBytes += _allItems.bytes();
+        return shape;
+    }
+
+    /**
+     * @brief Whether handle still refers to an item of the container.
+     */
+    [[nodiscard]] inline bool contains(const Handle &handle) const noexcept { return _allItems.contains(handle); }
+
+    [[nodiscard]] inline OBJ_TYPE &operator[](const Handle &handle) noexcept { return _allItems[handle].item; }
+
+    [[nodiscard]] inline const OBJ_TYPE &operator[](const Handle &handle) const noexcept
+    {
+        return _allItems[handle].item;
+    }
+
+    /**
+     * @brief Handle of the item that it points to, when walking the items from begin() to end().
+     */
+    [[nodiscard]] inline Handle handle(typename OctreeContainer::const_iterator it) const noexcept
+    {
+        return _allItems.handle_at(static_cast<size_t>(it - _allItems.begin()));
+    }
+
     [[nodiscard]] inline typename OctreeContainer::iterator begin() noexcept { return _allItems.begin(); }
 
     [[nodiscard]] inline typename OctreeContainer::iterator end() noexcept { return _allItems.end(); }
 
-    [[nodiscard]] inline typename OctreeContainer::const_iterator cbegin() const { return _allItems.cbegin(); }
+    [[nodiscard]] inline typename OctreeContainer::const_iterator cbegin() const { return _allItems.begin(); }
+
+    [[nodiscard]] inline typename OctreeContainer::const_iterator cend() const { return _allItems.end(); }
+
+    inline Handle insert(const OBJ_TYPE &item, const BoundaryBox &itemsize) noexcept
+    {
+        const Handle handle = _allItems.emplace(OctreeItem<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>{item, {}});
+        _allItems[handle].pItem = _root.insert(handle.index, itemsize, Relink{_allItems});
+        return handle;
+    }
+
+    [[nodiscard]] inline std::vector<Handle> search(const BoundaryBox &rArea) const noexcept
+    {
+        std::vector<Handle> handles;
+        search(rArea, std::back_inserter(handles));
+        return handles;
+    }
+
+    template <std::output_iterator<Handle> OUT_IT>
+    inline OUT_IT search(const BoundaryBox &rArea, OUT_IT out) const noexcept
+    {
+        _root.search(rArea, [this, &out](uint32_t slot) { *out++ = _allItems.handle(slot); });
+        return out;
+    }
+
+    template <typename FUNC>
+        requires std::invocable<FUNC &, Handle>
+    inline void search(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        _root.search(rArea, [this, &visitor](uint32_t slot) { visitor(_allItems.handle(slot)); });
+    }
+
+    template <typename FUNC>
+        requires std::invocable<FUNC &, Handle>
+    inline void search(const Frustum &frustum, FUNC &&visitor) const noexcept
+    {
+        _root.search(frustum, [this, &visitor](uint32_t slot) { visitor(_allItems.handle(slot)); });
+    }
+
+    /**
+     * @brief Call visitor(query, item) for every item overlapping areas[query], see DynamicOctree::search_batch().
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, uint32_t, Handle>
+    inline void search_batch(std::span<const BoundaryBox> areas, FUNC &&visitor,
+                             ThreadPool *threadPool = nullptr) const noexcept
+    {
+        _root.search_batch(
+            areas, [this, &visitor](uint32_t query, uint32_t slot) { visitor(query, _allItems.handle(slot)); },
+            threadPool);
+    }
+
+    /**
+     * @brief Fill results[query] with the items overlapping areas[query], reusing the capacity of the vectors.
+     */
+    inline void search_batch(std::span<const BoundaryBox> areas, std::vector<std::vector<Handle>> &results,
+                             ThreadPool *threadPool = nullptr) const noexcept
+    {
+        results.resize(areas.size());
+        for (std::vector<Handle> &found : results)
+            found.clear();
+
+        search_batch(
+            areas, [&results](uint32_t query, Handle item) { results[query].emplace_back(item); }, threadPool);
+    }
+
+    [[nodiscard]] inline size_t count(const BoundaryBox &rArea) const noexcept { return _root.count(rArea); }
+
+    /**
+     * @brief Combine value(item) or value(item, bounds) over the items overlapping rArea, see
+     * DynamicOctree::aggregate().
+     */
+    template <typename VALUE, typename FUNC, typename COMBINE = std::plus<>>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &>, VALUE> ||
+                 std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &, const BoundaryBox &>, VALUE>
+    [[nodiscard]] inline VALUE aggregate(const BoundaryBox &rArea, OctreeAggregate<VALUE> &cache, FUNC &&value,
+                                         COMBINE &&combine = {}) noexcept
+    {
+        if constexpr (std::is_invocable_v<FUNC &, const OBJ_TYPE &, const BoundaryBox &>)
+        {
+            return _root.aggregate(
+                rArea, cache,
+                [this, &value](uint32_t slot, const BoundaryBox &itemsize) -> VALUE {
+                    return value(_allItems.at(slot).item, itemsize);
+                },
+                combine);
+        }
+        else
+        {
+            return _root.aggregate(
+                rArea, cache, [this, &value](uint32_t slot) -> VALUE { return value(_allItems.at(slot).item); },
+                combine);
+        }
+    }
+
+    /**
+     * @brief Barnes-Hut walk around point, visitor(item) for the items close to it and far(summary) for the groups
+     * of items taken as one, see DynamicOctree::approximate_visit().
+     */
+    template <typename FUNC, typename NEAR, typename FAR>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &>, float> &&
+                 std::invocable<NEAR &, Handle> && std::invocable<FAR &, const OctreeMass &>
+    inline void approximate_visit(const glm::vec3 &point, float theta, OctreeAggregate<OctreeMass> &cache,
+                                  FUNC &&mass, NEAR &&visitor, FAR &&far) noexcept
+    {
+        _root.approximate_visit(
+            point, theta, cache, [this, &mass](uint32_t slot) { return mass(_allItems.at(slot).item); },
+            [this, &visitor](uint32_t slot) { visitor(_allItems.handle(slot)); }, far);
+    }
+
+    /**
+     * @brief Search rArea again with query, enter(item) is called for every item that overlaps it and did not at the
+     * previous search, exit(item) for every one that no longer does or was removed from the container since.
+     *
+     * Only the nodes changed since the previous search and the ones between the previous area and rArea are searched
+     * again, see DynamicOctree::search_changes(). The items that relocate() moves to another node or that remove()
+     * drops are reported to the query right away, so a still area over a still container costs nothing. The first
+     * search of a query reports every item it finds as entered.
+     */
+    template <typename AREA, typename ENTER, typename EXIT>
+        requires std::invocable<ENTER &, const OBJ_TYPE &> && std::invocable<EXIT &, const OBJ_TYPE &>
+    inline void search(Query<AREA> &query, const AREA &rArea, ENTER &&enter, EXIT &&exit) noexcept
+    {
+        const uint32_t since = std::exchange(query._since, _root.stamp());
+        const AREA previous = std::exchange(query._area, rArea);
+
+        if (!query._found)
+        {
+            std::erase_if(_queries, [](const std::weak_ptr<Found> &found) { return found.expired(); });
+            query._found = std::make_shared<Found>();
+            query._found->store = &_allItems;
+            _queries.emplace_back(query._found);
+
+            _root.search(rArea, [this, &query, &enter](uint32_t slot) {
+                query._found->items.insert(slot);
+                enter(_allItems.at(slot).item);
+            });
+            return;
+        }
+
+        Found &found = *query._found;
+
+        for (const OBJ_TYPE &item : found.removed)
+            exit(item);
+        found.removed.clear();
+
+        _root.search_changes(previous, rArea, since, [&](uint32_t slot, bool inside) {
+            if (!inside)
+            {
+                if (found.items.erase(slot))
+                {
+                    found.moved.erase(slot);
+                    exit(_allItems.at(slot).item);
+                }
+            }
+            else if (found.items.insert(slot).second)
+                enter(_allItems.at(slot).item);
+            else
+                found.moved.erase(slot);
+        });
+
+        // the moved items that were not met went to a node away from both areas
+        for (const uint32_t slot : found.moved)
+        {
+            found.items.erase(slot);
+            exit(_allItems.at(slot).item);
+        }
+        found.moved.clear();
+    }
+
+    /**
+     * @brief The count items closest to point, nearest first, see DynamicOctree::nearest().
+     */
+    template <typename FILTER = OctreeAcceptAll>
+        requires std::predicate<FILTER &, Handle>
+    [[nodiscard]] inline std::vector<OctreeNeighbour<Handle>>
+    nearest(const glm::vec3 &point, size_t count, float maxDistance = std::numeric_limits<float>::infinity(),
+            FILTER &&filter = {}) const noexcept
+    {
+        const std::vector<OctreeNeighbour<uint32_t>> found = _root.nearest(
+            point, count, maxDistance, [this, &filter](uint32_t slot) { return filter(_allItems.handle(slot)); });
+
+        std::vector<OctreeNeighbour<Handle>> neighbours;
+        neighbours.reserve(found.size());
+        for (const OctreeNeighbour<uint32_t> &neighbour : found)
+            neighbours.push_back({_allItems.handle(neighbour.item), neighbour.distance2});
+        return neighbours;
+    }
+
+    /**
+     * @brief Closest item hit by a ray, see DynamicOctree::raycast().
+     */
+    template <typename FUNC = OctreeBoundsHit>
+        requires std::is_invocable_r_v<float, FUNC &, Handle, float>
+    [[nodiscard]] inline std::optional<OctreeRayHit<Handle>> raycast(const glm::vec3 &origin,
+                                                                     const glm::vec3 &direction, float tmax,
+                                                                     FUNC &&hit = {}) const noexcept
+    {
+        const std::optional<OctreeRayHit<uint32_t>> found =
+            _root.raycast(origin, direction, tmax,
+                          [this, &hit](uint32_t slot, float entry) { return hit(_allItems.handle(slot), entry); });
+
+        if (!found)
+            return std::nullopt;
+        return OctreeRayHit<Handle>{_allItems.handle(found->item), found->distance};
+    }
 
-    [[nodiscard]] inline typename OctreeContainer::const_iterator cend() const { return _allItems.cend(); }
+    template <typename FUNC = OctreeBoundsHit>
+        requires std::is_invocable_r_v<float, FUNC &, Handle, float>
+    [[nodiscard]] inline bool raycast_any(const glm::vec3 &origin, const glm::vec3 &direction, float tmax,
+                                          FUNC &&hit = {}) const noexcept
+    {
+        return _root.raycast_any(origin, direction, tmax, [this, &hit](uint32_t slot, float entry) {
+            return hit(_allItems.handle(slot), entry);
+        });
+    }
 
-    inline void insert(const OBJ_TYPE &item, const BoundaryBox &itemsize) noexcept
+    /**
+     * @brief Call visitor(a, b) once for every pair of items whose bounds overlap, see
+     * DynamicOctree::overlapping_pairs().
+     */
+    template <typename FUNC>
+        requires std::invocable<FUNC &, Handle, Handle>
+    inline void overlapping_pairs(FUNC &&visitor) const noexcept
     {
-        OctreeItem<OBJ_TYPE> newItem;
-        newItem.item = item;
-        _allItems.emplace_back(newItem);
-        _allItems.back().pItem = _root.insert(std::prev(_allItems.end()), itemsize);
+        _root.overlapping_pairs(
+            [this, &visitor](uint32_t a, uint32_t b) { visitor(_allItems.handle(a), _allItems.handle(b)); });
     }
 
-    [[nodiscard]] inline std::list<typename OctreeContainer::iterator> search(const BoundaryBox &rArea) const noexcept
+    inline void overlapping_pairs(std::vector<std::pair<Handle, Handle>> &pairs,
+                                  ThreadPool *threadPool = nullptr) const noexcept
     {
-        std::list<typename OctreeContainer::iterator> listItemsPointers;
-        _root.search(rArea, listItemsPointers);
-        return listItemsPointers;
+        std::vector<std::pair<uint32_t, uint32_t>> slots;
+        _root.overlapping_pairs(slots, threadPool);
+
+        pairs.reserve(pairs.size() + slots.size());
+        for (const auto &[a, b] : slots)
+            pairs.emplace_back(_allItems.handle(a), _allItems.handle(b));
     }
 
-    inline void remove(typename OctreeContainer::iterator item) noexcept
+    /**
+     * @brief Remove an item, nothing happens if it was already removed.
+     */
+    inline void remove(const Handle &item) noexcept
     {
-        item->pItem.container->erase(item->pItem.iterator);
+        if (!_allItems.contains(item))
+            return;
+
+        leave(item.index, true);
+        _root.remove(_allItems[item].pItem, Relink{_allItems});
         _allItems.erase(item);
     }
 
-    inline void relocate(typename OctreeContainer::iterator &item, const BoundaryBox &itemsize) noexcept
+    /**
+     * @brief Remove many items in one pass, the octree work is grouped by node.
+     */
+    inline void remove_batch(std::span<const Handle> items) noexcept
+    {
+        std::vector<Location> locations;
+        locations.reserve(items.size());
+
+        for (const Handle &item : items)
+        {
+            // a handle given twice is only taken once, its location is cleared once it is
+            if (!_allItems.contains(item) || !_allItems[item].pItem.node)
+                continue;
+
+            leave(item.index, true);
+            locations.emplace_back(_allItems[item].pItem);
+            _allItems[item].pItem.node = nullptr;
+        }
+
+        _root.remove_batch(locations, Relink{_allItems});
+
+        for (const Handle &item : items)
+            _allItems.erase(item);
+    }
+
+    /**
+     * @brief Insert a whole range of objects at once, bounds(object) gives the bounds of each of them.
+     *
+     * On an empty container the octree is built in a single pass, its subtrees in parallel on threadPool when one is
+     * given.
+     */
+    template <typename FUNC>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &>, BoundaryBox>
+    inline void insert_bulk(std::span<const OBJ_TYPE> objects, FUNC &&bounds, ThreadPool *threadPool = nullptr) noexcept
+    {
+        std::vector<OctreeBulkItem<uint32_t>> items;
+        items.reserve(objects.size());
+        _allItems.reserve(_allItems.size() + objects.size());
+
+        for (const OBJ_TYPE &object : objects)
+        {
+            const Handle handle = _allItems.emplace(OctreeItem<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>{object, {}});
+            items.push_back({handle.index, bounds(object)});
+        }
+
+        _root.insert_bulk(std::span(items), threadPool, Relink{_allItems});
+    }
+
+    /**
+     * @brief Insert an item again after its bounds changed, nothing happens if it was removed.
+     */
+    inline void relocate(const Handle &item, const BoundaryBox &itemsize) noexcept
+    {
+        if (_allItems.contains(item))
+            relocate(item.index, itemsize);
+    }
+
+    /**
+     * @brief Move every item in one pass, update(item) changes the item and returns its new bounds.
+     *
+     * Items that are still inside the bounds of their node are updated in place, only the ones that left it are
+     * inserted again from the root. The items are walked in the order they are stored.
+     */
+    template <typename FUNC>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, OBJ_TYPE &>, BoundaryBox>
+    inline void relocate_all(FUNC &&update) noexcept
+    {
+        for (size_t position = 0; position < _allItems.size(); ++position)
+        {
+            auto &entry = *(_allItems.begin() + static_cast<std::ptrdiff_t>(position));
+            const BoundaryBox itemsize = update(entry.item);
+
+            if (!_root.update(entry.pItem, itemsize))
+                relocate(_allItems.handle_at(position).index, itemsize);
+        }
+    }
+
+    /**
+     * @brief Immutable copy of the items, that other threads can query while the container keeps changing.
+     *
+     * The nodes that did not change since the previous snapshot are shared with it. An item is copied again when its
+     * bounds are updated, changes that keep the bounds must go through relocate() to reach the next snapshot.
+     */
+    [[nodiscard]] inline std::shared_ptr<const Snapshot> snapshot() noexcept
     {
-        item->pItem.container->erase(item->pItem.iterator);
-        item->pItem = _root.insert(item, itemsize);
+        _snapshot = _root.snapshot(_snapshot, [this](uint32_t slot) { return _allItems.at(slot).item; });
+        return _snapshot;
     }
 
 #ifdef DEBUG
     inline void draw(sf::RenderWindow &window, const BoundaryBox &rArea) const noexcept { _root.draw(window, rArea); }
 #endif
 
+private:
+    struct Relink {
+        OctreeContainer &items;
+
+        inline void operator()(uint32_t slot, const Location &location) const noexcept
+        {
+            items.at(slot).pItem = location;
+        }
+    };
+
+    inline void relocate(uint32_t slot, const BoundaryBox &itemsize) noexcept
+    {
+        leave(slot, false);
+        _root.remove(_allItems.at(slot).pItem, Relink{_allItems});
+        const Location location = _root.insert(slot, itemsize, Relink{_allItems});
+        _allItems.at(slot).pItem = location;
+    }
+
+    /**
+     * @brief Tell the queries that found the item in slot that it is about to leave the container, or only its node.
+     */
+    inline void leave(uint32_t slot, bool removed) noexcept
+    {
+        for (const std::weak_ptr<Found> &query : _queries)
+        {
+            const std::shared_ptr<Found> found = query.lock();
+
+            if (!found || !found->items.contains(slot))
+                continue;
+
+            if (!removed)
+            {
+                found->moved.insert(slot);
+                continue;
+            }
+
+            found->items.erase(slot);
+            found->moved.erase(slot);
+            found->removed.emplace_back(_allItems.at(slot).item);
+        }
+    }
+
+    inline void leave_all() noexcept
+    {
+        for (const std::weak_ptr<Found> &query : _queries)
+        {
+            const std::shared_ptr<Found> found = query.lock();
+
+            if (!found)
+                continue;
+
+            for (const uint32_t slot : found->items)
+                found->removed.emplace_back(_allItems.at(slot).item);
+
+            found->items.clear();
+            found->moved.clear();
+        }
+    }
+
 protected:
     OctreeContainer _allItems;
-    DynamicOctree<typename OctreeContainer::iterator> _root;
+    Tree _root;
+    std::shared_ptr<const Snapshot> _snapshot; // last one taken, the next one shares its unchanged nodes
+    std::vector<std::weak_ptr<Found>> _queries; // of the Query handles that searched this container
 };
+
+template <typename OBJ_TYPE> using DynamicQuadtree = DynamicOctree<OBJ_TYPE, 2u>;
+template <typename OBJ_TYPE> using DynamicQuadtreeContainer = DynamicOctreeContainer<OBJ_TYPE, 2u>;
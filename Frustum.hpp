@@ -0,0 +1,133 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file Frustum.hpp
+ * @brief View Frustum with Plane-Mask Box Classification.
+ *
+ * A frustum is kept as six inward facing planes. Boxes are classified
+ * against the planes that are still set in a mask, and a plane the box
+ * lies fully inside of is cleared from the mask, so the children of a box
+ * only test the planes their parent straddles.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include "BoundaryBox.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+class Frustum {
+public:
+    enum PLANE : uint8_t {
+        LEFT,
+        RIGHT,
+        BOTTOM,
+        TOP,
+        FRONT, // near plane
+        BACK,  // far plane
+        PLANE_COUNT
+    };
+
+    static constexpr uint8_t ALL_PLANES = (1u << PLANE_COUNT) - 1u;
+    static constexpr uint8_t OUTSIDE = 1u << PLANE_COUNT; // never part of a plane mask
+
+public:
+    Frustum() = default;
+
+    /**
+     * @param planes (a, b, c, d) of every plane, a point p is on the inner side when a * p.x + b * p.y + c * p.z + d
+     * is positive. They do not need to be normalized.
+     */
+    explicit Frustum(const std::array<glm::vec4, PLANE_COUNT> &planes) noexcept
+    {
+        for (uint8_t i = 0; i < PLANE_COUNT; ++i)
+            setPlane(i, planes[i]);
+    }
+
+    /**
+     * @brief Extract the planes of a projection * view matrix, with the OpenGL clip space that glm builds by default.
+     */
+    [[nodiscard]] static inline Frustum fromMatrix(const glm::mat4 &viewProjection) noexcept
+    {
+        const auto row = [&viewProjection](uint8_t i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+
+        return Frustum({row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2),
+                        row(3) - row(2)});
+    }
+
+    /**
+     * @brief Classify box against the planes set in mask.
+     *
+     * @return OUTSIDE when the box is fully outside one of the planes, otherwise mask without the planes the box is
+     * fully inside of. 0 means the box is fully inside the frustum.
+     */
+    [[nodiscard]] inline uint8_t classify(const BoundaryBox &box, uint8_t mask = ALL_PLANES) const noexcept
+    {
+        const glm::vec3 &min = box.getMin();
+        const glm::vec3 &max = box.getMax();
+
+        for (uint8_t i = 0; i < PLANE_COUNT; ++i)
+        {
+            if (!(mask & (1u << i)))
+                continue;
+
+            const glm::vec3 &normal = _normals[i];
+            const glm::vec3 farthest(normal.x >= 0.f ? max.x : min.x, normal.y >= 0.f ? max.y : min.y,
+                                     normal.z >= 0.f ? max.z : min.z);
+
+            if (glm::dot(normal, farthest) + _distances[i] < 0.f)
+                return OUTSIDE;
+
+            const glm::vec3 nearest(normal.x >= 0.f ? min.x : max.x, normal.y >= 0.f ? min.y : max.y,
+                                    normal.z >= 0.f ? min.z : max.z);
+
+            if (glm::dot(normal, nearest) + _distances[i] >= 0.f)
+                mask &= static_cast<uint8_t>(~(1u << i));
+        }
+
+        return mask;
+    }
+
+    [[nodiscard]] inline bool operator==(const Frustum &other) const noexcept
+    {
+        return _normals == other._normals && _distances == other._distances;
+    }
+
+    [[nodiscard]] inline bool overlaps(const BoundaryBox &box) const noexcept { return classify(box) != OUTSIDE; }
+    [[nodiscard]] inline bool contains(const BoundaryBox &box) const noexcept { return classify(box) == 0u; }
+
+private:
+    inline void setPlane(uint8_t i, const glm::vec4 &plane) noexcept
+    {
+        const glm::vec3 normal(plane.x, plane.y, plane.z);
+        const float length = std::sqrt(glm::dot(normal, normal));
+
+        _normals[i] = normal / length;
+        _distances[i] = plane.w / length;
+    }
+
+private:
+    std::array<glm::vec3, PLANE_COUNT> _normals{};
+    std::array<float, PLANE_COUNT> _distances{};
+};
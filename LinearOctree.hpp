@@ -0,0 +1,559 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file LinearOctree.hpp
+ * @brief Pointerless Linear Octree sorted along a 3D Morton Curve.
+ *
+ * Every item is assigned to the deepest octree cell that fully contains it,
+ * exactly like DynamicOctree does, but the cells are never allocated. The
+ * cell is encoded as a Morton location code and the items are kept sorted by
+ * that code in contiguous arrays, so every subtree of the implicit octree is
+ * a contiguous run of the arrays and is found with a binary search.
+ *
+ * The objects live in a SlotMap and the arrays only hold their slots. New
+ * and moved entries wait unsorted at the end of the arrays and removed ones
+ * leave holes, both are folded back in one merge once they pile up, so that
+ * inserting or removing an item never shifts the whole arrays.
+ *
+ * The container exposes the same surface as DynamicOctreeContainer, handles
+ * included, and can be used in its place (see BasicPartition).
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include "DynamicOctree.hpp"
+
+#include <bit>
+#include <cstdint>
+
+/**
+ * @brief Spread the 16 low bits of v so that there are two zero bits between each of them.
+ */
+[[nodiscard]] constexpr uint64_t morton_spread(uint64_t v) noexcept
+{
+    v &= 0xFFFFu;
+    v = (v | (v << 16)) & 0x0000FF0000FFull;
+    v = (v | (v << 8)) & 0x00F00F00F00Full;
+    v = (v | (v << 4)) & 0x0C30C30C30C3ull;
+    v = (v | (v << 2)) & 0x249249249249ull;
+    return v;
+}
+
+/**
+ * @brief 3D Morton code, x takes the lowest bit to match the DynamicOctree child index (SWD, SED, NWD, ...).
+ */
+[[nodiscard]] constexpr uint64_t morton_encode(uint32_t x, uint32_t y, uint32_t z) noexcept
+{
+    return morton_spread(x) | (morton_spread(y) << 1) | (morton_spread(z) << 2);
+}
+
+template <typename OBJ_TYPE> struct LinearOctreeItem {
+    OBJ_TYPE item;
+    uint32_t position = 0; // of the entry of the item in the arrays sorted along the Morton curve
+};
+
+template <typename OBJ_TYPE> class LinearOctreeContainer {
+public:
+    using OctreeContainer = SlotMap<LinearOctreeItem<OBJ_TYPE>>;
+    using Handle = SlotHandle;
+    using Snapshot = OctreeSnapshot<OBJ_TYPE>;
+
+    static constexpr uint8_t MAX_LINEAR_DEPTH = 16u;
+
+private:
+    static constexpr uint64_t LEVEL_BITS = 5u;
+    static constexpr uint64_t LEVEL_MASK = (1u << LEVEL_BITS) - 1u;
+    static constexpr uint32_t REMOVED = OctreeContainer::NO_SLOT; // slot of the entry of a removed item
+    static constexpr size_t MIN_PENDING = 64u; // unsorted entries and holes tolerated before sorting again
+
+public:
+    LinearOctreeContainer(const BoundaryBox &size, const uint8_t capacity = MAX_CAPACITY,
+                          const uint8_t depth = MAX_DEPTH) noexcept
+        : _DEPTH(std::min(depth, MAX_LINEAR_DEPTH)), _CAPACITY(capacity), _boundary(size)
+    {
+    }
+    LinearOctreeContainer(const LinearOctreeContainer &other) = delete;
+    LinearOctreeContainer &operator=(const LinearOctreeContainer &other) = delete;
+    ~LinearOctreeContainer() = default;
+
+    inline void resize(const BoundaryBox &rArea) noexcept
+    {
+        if (_boundary == rArea)
+            return;
+
+        clear();
+        _boundary = rArea;
+    }
+
+    [[nodiscard]] inline size_t size() const noexcept { return _allItems.size(); }
+
+    [[nodiscard]] inline bool empty() const noexcept { return _allItems.empty(); }
+
+    inline void clear() noexcept
+    {
+        _keys.clear();
+        _bounds.clear();
+        _slots.clear();
+        _allItems.clear();
+        _sorted = 0;
+        _removed = 0;
+    }
+
+    inline void reserve(size_t count)
+    {
+        _keys.reserve(count);
+        _bounds.reserve(count);
+        _slots.reserve(count);
+        _allItems.reserve(count);
+    }
+
+    [[nodiscard]] inline const BoundaryBox &boundary() const noexcept { return _boundary; }
+
+    [[nodiscard]] inline bool contains(const Handle &handle) const noexcept { return _allItems.contains(handle); }
+
+    [[nodiscard]] inline OBJ_TYPE &operator[](const Handle &handle) noexcept { return _allItems[handle].item; }
+
+    [[nodiscard]] inline const OBJ_TYPE &operator[](const Handle &handle) const noexcept
+    {
+        return _allItems[handle].item;
+    }
+
+    /**
+     * @brief Handle of the item an iterator of begin()/end() points to.
+     */
+    [[nodiscard]] inline Handle handle(typename OctreeContainer::const_iterator it) const noexcept
+    {
+        return _allItems.handle_at(static_cast<size_t>(it - _allItems.begin()));
+    }
+
+    [[nodiscard]] inline typename OctreeContainer::iterator begin() noexcept { return _allItems.begin(); }
+
+    [[nodiscard]] inline typename OctreeContainer::iterator end() noexcept { return _allItems.end(); }
+
+    [[nodiscard]] inline typename OctreeContainer::const_iterator cbegin() const { return _allItems.begin(); }
+
+    [[nodiscard]] inline typename OctreeContainer::const_iterator cend() const { return _allItems.end(); }
+
+    /**
+     * @brief Insert an item, its entry waits at the end of the arrays until enough of them are sorted in at once.
+     */
+    inline Handle insert(const OBJ_TYPE &item, const BoundaryBox &itemsize) noexcept
+    {
+        const Handle handle = _allItems.emplace(LinearOctreeItem<OBJ_TYPE>{item, 0u});
+        append(handle.index, key_of(itemsize), itemsize);
+        settle();
+        return handle;
+    }
+
+    [[nodiscard]] inline std::vector<Handle> search(const BoundaryBox &rArea) const noexcept
+    {
+        std::vector<Handle> handles;
+        search(rArea, std::back_inserter(handles));
+        return handles;
+    }
+
+    template <std::output_iterator<Handle> OUT_IT>
+    inline OUT_IT search(const BoundaryBox &rArea, OUT_IT out) const noexcept
+    {
+        search(rArea, [&out](const Handle &item) { *out++ = item; });
+        return out;
+    }
+
+    template <typename FUNC>
+        requires std::invocable<FUNC &, Handle>
+    inline void search(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        const auto visit = [this, &visitor](size_t entry) {
+            if (_slots[entry] != REMOVED)
+                visitor(_allItems.handle(_slots[entry]));
+        };
+
+        search(rArea, visit, 0u, {0u, 0u, 0u}, 0u, _sorted);
+        _bounds.overlaps(rArea, _sorted, _keys.size(), visit);
+    }
+
+    /**
+     * @brief Remove an item, nothing happens if it was already removed.
+     */
+    inline void remove(const Handle &item) noexcept
+    {
+        if (!_allItems.contains(item))
+            return;
+
+        unplace(item.index);
+        _allItems.erase(item);
+        settle();
+    }
+
+    /**
+     * @brief Remove many items, the holes they leave in the sorted arrays are compacted at most once.
+     */
+    inline void remove_batch(std::span<const Handle> items) noexcept
+    {
+        for (const Handle &item : items)
+        {
+            // a handle given twice is stale the second time
+            if (!_allItems.contains(item))
+                continue;
+
+            unplace(item.index);
+            _allItems.erase(item);
+        }
+
+        settle();
+    }
+
+    /**
+     * @brief Insert a whole range of objects at once, bounds(object) gives the bounds of each of them.
+     *
+     * The keys are computed in parallel on threadPool when one is given, then the new entries are sorted and merged
+     * into the arrays in a single sweep.
+     */
+    template <typename FUNC>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, const OBJ_TYPE &>, BoundaryBox>
+    inline void insert_bulk(std::span<const OBJ_TYPE> objects, FUNC &&bounds, ThreadPool *threadPool = nullptr) noexcept
+    {
+        constexpr size_t GRAIN = 2048u;
+        const size_t first = _keys.size();
+
+        _allItems.reserve(_allItems.size() + objects.size());
+        _keys.resize(first + objects.size());
+        _bounds.resize(first + objects.size());
+        _slots.resize(first + objects.size());
+
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            const Handle handle = _allItems.emplace(
+                LinearOctreeItem<OBJ_TYPE>{objects[i], static_cast<uint32_t>(first + i)});
+            _bounds.set(first + i, bounds(objects[i]));
+            _slots[first + i] = handle.index;
+        }
+
+        parallel_for(threadPool, (objects.size() + GRAIN - 1u) / GRAIN, [this, first, &objects](size_t chunk) {
+            for (size_t i = chunk * GRAIN; i < std::min(objects.size(), (chunk + 1u) * GRAIN); ++i)
+                _keys[first + i] = key_of(_bounds[first + i]);
+        });
+
+        flush();
+    }
+
+    /**
+     * @brief Move an item after its bounds changed, nothing happens if it was removed.
+     *
+     * An item that stays in its cell keeps its entry, the others leave a hole and wait at the end of the arrays.
+     */
+    inline void relocate(const Handle &item, const BoundaryBox &itemsize) noexcept
+    {
+        if (!_allItems.contains(item))
+            return;
+
+        const uint32_t position = _allItems[item].position;
+        const uint64_t key = key_of(itemsize);
+
+        // the entries past _sorted are not in order yet, they take any key in place
+        if (position >= _sorted || key == _keys[position])
+        {
+            _keys[position] = key;
+            _bounds.set(position, itemsize);
+            return;
+        }
+
+        _slots[position] = REMOVED;
+        ++_removed;
+        append(item.index, key, itemsize);
+        settle();
+    }
+
+    /**
+     * @brief Move every item in one pass, update(item) changes the item and returns its new bounds.
+     *
+     * The items are walked in Morton order. Items that stay in their cell are updated in place, the others are pulled
+     * out of the arrays, sorted, and merged back in a single sweep that also drops the holes.
+     */
+    template <typename FUNC>
+        requires std::convertible_to<std::invoke_result_t<FUNC &, OBJ_TYPE &>, BoundaryBox>
+    inline void relocate_all(FUNC &&update) noexcept
+    {
+        std::vector<Pending> moved;
+
+        size_t write = 0;
+        for (size_t read = 0; read < _keys.size(); ++read)
+        {
+            const uint32_t slot = _slots[read];
+            if (slot == REMOVED)
+                continue;
+
+            const BoundaryBox itemsize = update(_allItems.at(slot).item);
+            const uint64_t key = key_of(itemsize);
+
+            if (read >= _sorted || key != _keys[read])
+                moved.push_back({key, itemsize, slot});
+            else
+                keep(write++, key, itemsize, slot);
+        }
+
+        merge(write, moved);
+    }
+
+    /**
+     * @brief Immutable copy of the items, that other threads can query while the container keeps changing.
+     *
+     * The items are kept in a single node, in Morton order, and copied whole every time, unlike the snapshots of
+     * DynamicOctreeContainer that share the nodes which did not change.
+     */
+    [[nodiscard]] inline std::shared_ptr<const Snapshot> snapshot() noexcept
+    {
+        flush();
+
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->_boundary = _boundary;
+        snapshot->_count = static_cast<uint32_t>(_slots.size());
+        snapshot->_bounds = _bounds;
+        snapshot->_items.reserve(_slots.size());
+
+        for (const uint32_t slot : _slots)
+            snapshot->_items.emplace_back(_allItems.at(slot).item);
+
+        return snapshot;
+    }
+
+#ifdef DEBUG
+    inline void draw(sf::RenderWindow &window, const BoundaryBox &rArea) const noexcept
+    {
+        sf::RectangleShape rectangle;
+        rectangle.setPosition({rArea.getMin().x, rArea.getMin().y});
+        rectangle.setSize({rArea.getMax().x - rArea.getMin().x, rArea.getMax().y - rArea.getMin().y});
+        rectangle.setFillColor(sf::Color::Transparent);
+        rectangle.setOutlineColor(sf::Color::Green);
+        rectangle.setOutlineThickness(1);
+        window.draw(rectangle);
+    }
+#endif
+
+private:
+    struct Pending {
+        uint64_t key;
+        BoundaryBox itemsize;
+        uint32_t slot;
+    };
+
+    [[nodiscard]] inline size_t tolerance() const noexcept { return std::max(MIN_PENDING, _sorted / 8u); }
+
+    /**
+     * @brief Flush once there are too many waiting entries or holes, so that both stay a small part of the arrays.
+     */
+    inline void settle() noexcept
+    {
+        if (_keys.size() - _sorted > tolerance() || _removed > tolerance())
+            flush();
+    }
+
+    /**
+     * @brief Sort the waiting entries in and drop the holes.
+     */
+    inline void flush() noexcept
+    {
+        if (_sorted == _keys.size() && _removed == 0)
+            return;
+
+        std::vector<Pending> pending;
+        pending.reserve(_keys.size() - _sorted);
+        for (size_t i = _sorted; i < _keys.size(); ++i)
+            pending.push_back({_keys[i], _bounds[i], _slots[i]});
+
+        size_t write = 0;
+        for (size_t read = 0; read < _sorted; ++read)
+        {
+            if (_slots[read] != REMOVED)
+                keep(write++, _keys[read], _bounds[read], _slots[read]);
+        }
+
+        merge(write, pending);
+    }
+
+    /**
+     * @brief Sort the pending entries and merge them after the first kept entries of the arrays, which are sorted.
+     * The arrays end up holding exactly both, all of them sorted.
+     */
+    inline void merge(size_t kept, std::vector<Pending> &pending) noexcept
+    {
+        std::stable_sort(pending.begin(), pending.end(),
+                         [](const Pending &a, const Pending &b) { return a.key < b.key; });
+
+        size_t write = kept + pending.size();
+        _keys.resize(write);
+        _bounds.resize(write);
+        _slots.resize(write);
+        _sorted = write;
+        _removed = 0;
+
+        for (size_t next = pending.size(); next-- > 0;)
+        {
+            while (kept > 0 && _keys[kept - 1u] > pending[next].key)
+            {
+                --kept;
+                keep(--write, _keys[kept], _bounds[kept], _slots[kept]);
+            }
+
+            keep(--write, pending[next].key, pending[next].itemsize, pending[next].slot);
+        }
+    }
+
+    /**
+     * @brief Store an entry at position, the item it belongs to is told where it now is.
+     */
+    inline void keep(size_t position, uint64_t key, const BoundaryBox &itemsize, uint32_t slot) noexcept
+    {
+        _keys[position] = key;
+        _bounds.set(position, itemsize);
+        _slots[position] = slot;
+        _allItems.at(slot).position = static_cast<uint32_t>(position);
+    }
+
+    /**
+     * @brief Add an entry past the sorted ones.
+     */
+    inline void append(uint32_t slot, uint64_t key, const BoundaryBox &itemsize) noexcept
+    {
+        _allItems.at(slot).position = static_cast<uint32_t>(_keys.size());
+        _keys.push_back(key);
+        _bounds.push_back(itemsize);
+        _slots.push_back(slot);
+    }
+
+    /**
+     * @brief Take the entry of the item in slot out of the arrays. A sorted entry leaves a hole, an unsorted one is
+     * replaced by the last entry.
+     */
+    inline void unplace(uint32_t slot) noexcept
+    {
+        const size_t position = _allItems.at(slot).position;
+
+        if (position < _sorted)
+        {
+            _slots[position] = REMOVED;
+            ++_removed;
+            return;
+        }
+
+        _keys[position] = _keys.back();
+        _slots[position] = _slots.back();
+        _bounds.swap_pop(position);
+        _keys.pop_back();
+        _slots.pop_back();
+
+        if (position < _slots.size())
+            _allItems.at(_slots[position]).position = static_cast<uint32_t>(position);
+    }
+
+    /**
+     * @brief Sort key of an item: the Morton code of its cell padded to the full depth, then the cell level.
+     *
+     * Padding the code makes every subtree a contiguous key range, and the level in the low bits puts the items
+     * of a cell before the items of its children.
+     */
+    [[nodiscard]] inline uint64_t key_of(const BoundaryBox &itemsize) const noexcept
+    {
+        if (!_boundary.contains(itemsize))
+            return 0u;
+
+        const uint32_t cells = 1u << _DEPTH;
+        const glm::vec3 scale = glm::vec3(static_cast<float>(cells)) / _boundary.getSize();
+        const glm::vec3 lo = (itemsize.getMin() - _boundary.getMin()) * scale;
+        const glm::vec3 hi = (itemsize.getMax() - _boundary.getMin()) * scale;
+
+        uint32_t min[3], diff = 0;
+        for (uint8_t axis = 0; axis < 3u; ++axis)
+        {
+            min[axis] = std::min(static_cast<uint32_t>(std::max(lo[axis], 0.f)), cells - 1u);
+            diff |= min[axis] ^ std::min(static_cast<uint32_t>(std::max(hi[axis], 0.f)), cells - 1u);
+        }
+
+        const uint8_t level = static_cast<uint8_t>(_DEPTH - std::bit_width(diff));
+        const uint32_t mask = ~((1u << (_DEPTH - level)) - 1u);
+
+        return (morton_encode(min[0] & mask, min[1] & mask, min[2] & mask) << LEVEL_BITS) | level;
+    }
+
+    [[nodiscard]] inline BoundaryBox cell(uint8_t level, const glm::uvec3 &coord) const noexcept
+    {
+        const glm::vec3 size = _boundary.getSize() / static_cast<float>(1u << level);
+        return BoundaryBox(_boundary.getMin() + glm::vec3(coord) * size, size);
+    }
+
+    template <typename FUNC>
+    inline void emit(const BoundaryBox &rArea, FUNC &visitor, size_t first, size_t last) const noexcept
+    {
+        _bounds.overlaps(rArea, first, last, visitor);
+    }
+
+    template <typename FUNC>
+    inline void search(const BoundaryBox &rArea, FUNC &visitor, uint8_t level, const glm::uvec3 &coord, size_t first,
+                       size_t last) const noexcept
+    {
+        if (last - first <= _CAPACITY || level == _DEPTH)
+            return emit(rArea, visitor, first, last);
+
+        size_t own = first;
+        while (own < last && (_keys[own] & LEVEL_MASK) == level)
+            ++own;
+
+        emit(rArea, visitor, first, own);
+
+        const uint64_t shift = 3u * (_DEPTH - level - 1u) + LEVEL_BITS;
+        const uint64_t base = morton_encode(coord.x, coord.y, coord.z) << 3u;
+
+        for (uint8_t i = 0; i < 8u && own < last; ++i)
+        {
+            const size_t next = std::lower_bound(_keys.begin() + own, _keys.begin() + last, (base + i + 1u) << shift) -
+                                _keys.begin();
+
+            if (next == own)
+                continue;
+
+            const glm::uvec3 child{coord.x * 2u + (i & 1u), coord.y * 2u + ((i >> 1) & 1u), coord.z * 2u + (i >> 2)};
+            const BoundaryBox rNode = cell(level + 1u, child);
+
+            if (rArea.contains(rNode))
+            {
+                for (size_t j = own; j < next; ++j)
+                    visitor(j);
+            }
+            else if (rArea.overlaps(rNode))
+                search(rArea, visitor, level + 1u, child, own, next);
+
+            own = next;
+        }
+    }
+
+protected:
+    const uint8_t _DEPTH = MAX_DEPTH;
+    const uint8_t _CAPACITY = MAX_CAPACITY;
+
+    BoundaryBox _boundary{};
+
+    OctreeContainer _allItems;
+
+    std::vector<uint64_t> _keys; // sorted up to _sorted, the entries past it wait for the next flush()
+    BoundaryBoxBlock _bounds;
+    std::vector<uint32_t> _slots; // slot of the item of every entry, REMOVED for a hole
+    size_t _sorted = 0;
+    size_t _removed = 0; // holes among the sorted entries
+};
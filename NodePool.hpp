@@ -0,0 +1,154 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file NodePool.hpp
+ * @brief Block Arena for Fixed-Size Tree Nodes.
+ *
+ * Nodes are carved out of fixed-size blocks that stay alive for the whole
+ * lifetime of the pool. Releasing the pool destroys every node at once and
+ * keeps the blocks, so the next fill of the tree does not touch the global
+ * allocator at all and sibling nodes end up next to each other in memory.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+template <typename NODE_TYPE, size_t BLOCK_SIZE = 256u> class NodePool {
+private:
+    struct Block {
+        alignas(NODE_TYPE) std::byte storage[sizeof(NODE_TYPE) * BLOCK_SIZE];
+        size_t used = 0;
+    };
+
+public:
+    NodePool() = default;
+    NodePool(const NodePool &other) = delete;
+    NodePool &operator=(const NodePool &other) = delete;
+    ~NodePool() { release(); }
+
+    template <typename... Args> [[nodiscard]] inline NODE_TYPE *allocate(Args &&...args)
+    {
+        if (!_free.empty())
+        {
+            NODE_TYPE *node = ::new (static_cast<void *>(_free.back())) NODE_TYPE(std::forward<Args>(args)...);
+            _free.pop_back();
+            return node;
+        }
+
+        while (_current < _blocks.size() && _blocks[_current]->used == BLOCK_SIZE)
+            ++_current;
+
+        if (_current == _blocks.size())
+            _blocks.emplace_back(std::make_unique<Block>());
+
+        Block &block = *_blocks[_current];
+        NODE_TYPE *node = ::new (static_cast<void *>(slot(block, block.used))) NODE_TYPE(std::forward<Args>(args)...);
+        ++block.used;
+        ++_used;
+        return node;
+    }
+
+    /**
+     * @brief Destroy a single node, its slot is reused by the next allocation.
+     */
+    inline void deallocate(NODE_TYPE *node) noexcept
+    {
+        std::destroy_at(node);
+        _free.push_back(node);
+    }
+
+    /**
+     * @brief Take over every block and node of another pool, which is left empty.
+     *
+     * Used to build subtrees on other threads with their own pool and hand them to the tree afterwards.
+     */
+    inline void adopt(NodePool &other)
+    {
+        for (std::unique_ptr<Block> &block : other._blocks)
+        {
+            if (block->used)
+                _blocks.emplace_back(std::move(block));
+        }
+
+        _free.insert(_free.end(), other._free.begin(), other._free.end());
+        _used += other._used;
+        _current = 0;
+
+        other._blocks.clear();
+        other._free.clear();
+        other._used = 0;
+        other._current = 0;
+    }
+
+    /**
+     * @brief Destroy every node handed out so far in one sweep.
+     *
+     * The blocks themselves are kept for the next fill.
+     */
+    inline void release() noexcept
+    {
+        std::sort(_free.begin(), _free.end());
+
+        for (std::unique_ptr<Block> &block : _blocks)
+        {
+            for (size_t i = 0; i < block->used; ++i)
+            {
+                if (!std::binary_search(_free.begin(), _free.end(), slot(*block, i)))
+                    std::destroy_at(slot(*block, i));
+            }
+
+            block->used = 0;
+        }
+
+        _free.clear();
+        _used = 0;
+        _current = 0;
+    }
+
+    /**
+     * @brief Give the unused blocks back to the global allocator.
+     */
+    inline void shrink_to_fit() noexcept
+    {
+        std::erase_if(_blocks, [](const std::unique_ptr<Block> &block) { return block->used == 0; });
+        _blocks.shrink_to_fit();
+        _current = 0;
+    }
+
+    [[nodiscard]] inline size_t size() const noexcept { return _used - _free.size(); }
+    [[nodiscard]] inline size_t capacity() const noexcept { return _blocks.size() * BLOCK_SIZE; }
+
+private:
+    [[nodiscard]] static inline NODE_TYPE *slot(Block &block, size_t index) noexcept
+    {
+        return reinterpret_cast<NODE_TYPE *>(block.storage) + index;
+    }
+
+private:
+    std::vector<std::unique_ptr<Block>> _blocks;
+    std::vector<NODE_TYPE *> _free;
+    size_t _used = 0;    // slots handed out, including the freed ones
+    size_t _current = 0; // every block before it is full
+};
@@ -0,0 +1,163 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file OctreeTuner.hpp
+ * @brief Pick the Depth and Capacity of a Dynamic Octree for its Objects.
+ *
+ * A single depth and capacity cannot suit a dense city block and an empty
+ * field at once. The tuner estimates them from the number and the size of
+ * the objects a tree is about to hold, and can refine the estimate by
+ * timing the queries that will actually run on trees built around it.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include "DynamicOctree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Parameters of the nodes of a tree.
+ */
+struct OctreeTuning {
+    uint8_t capacity = MAX_CAPACITY;
+    uint8_t depth = MAX_DEPTH;
+
+    [[nodiscard]] inline bool operator==(const OctreeTuning &other) const noexcept = default;
+};
+
+template <typename SPATIAL_CONTAINER> class OctreeTuner;
+
+template <typename OBJ_TYPE, uint8_t DIMENSION, typename BOUNDS_BLOCK>
+class OctreeTuner<DynamicOctreeContainer<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>> {
+public:
+    using Container = DynamicOctreeContainer<OBJ_TYPE, DIMENSION, BOUNDS_BLOCK>;
+
+    // the overlap kernel goes through a leaf this large in about the time a level of nodes takes to walk
+    static constexpr uint8_t LEAF_CAPACITY = 128u;
+    static constexpr uint8_t DEPTH_LIMIT = 16u;
+    static constexpr int CALIBRATION_RUNS = 2; // the fastest run of each candidate is kept
+
+public:
+    /**
+     * @brief Estimate the parameters from the bounds of the objects alone.
+     *
+     * A cell with no more objects than a leaf holds stays a single leaf. Otherwise the depth is the smaller of two
+     * limits: the level at which the leaves would hold about a leaf worth of objects if they were spread evenly, one
+     * more for clusters, and the deepest level whose nodes are still twice as wide as the median object, since
+     * deeper nodes could not hold most of them.
+     */
+    [[nodiscard]] static inline OctreeTuning estimate(const BoundaryBox &boundary, std::span<const BoundaryBox> bounds,
+                                                      const float looseness = TIGHT_LOOSENESS) noexcept
+    {
+        if (bounds.size() <= LEAF_CAPACITY)
+            return {LEAF_CAPACITY, 0u};
+
+        // size of every object relative to the boundary, along the split axis where it is the largest
+        std::vector<float> sizes;
+        sizes.reserve(bounds.size());
+
+        const glm::vec3 extent = boundary.getSize();
+        for (const BoundaryBox &itemsize : bounds)
+        {
+            float size = 0.f;
+            for (uint8_t bit = 0; bit < DIMENSION; ++bit)
+            {
+                const uint8_t axis = Container::Tree::SPLIT_AXES[bit];
+                size = std::max(size, itemsize.getSize()[axis] / extent[axis]);
+            }
+            sizes.push_back(size);
+        }
+
+        const auto median = sizes.begin() + static_cast<std::ptrdiff_t>(sizes.size() / 2u);
+        std::nth_element(sizes.begin(), median, sizes.end());
+
+        const double leaves = static_cast<double>(bounds.size()) / LEAF_CAPACITY;
+        const double byCount = std::ceil(std::log2(leaves) / DIMENSION) + 1.;
+        const double margin = std::max(looseness, TIGHT_LOOSENESS) / (2. * *median);
+        const double bySize = *median > 0.f ? std::floor(std::log2(margin)) : DEPTH_LIMIT;
+        const double depth = std::clamp(std::min(byCount, bySize), 0., static_cast<double>(DEPTH_LIMIT));
+
+        return {LEAF_CAPACITY, static_cast<uint8_t>(depth)};
+    }
+
+    /**
+     * @brief Refine the estimate on the queries that will run on the tree.
+     *
+     * Trees are built from objects with the estimate and its neighbours, one level shallower or deeper and half or
+     * twice the capacity, then queries(container) is timed on each of them and the fastest one wins. It costs a few
+     * bulk builds, so it is meant for load times.
+     *
+     * @param bounds bounds(object) gives the bounds of each object.
+     */
+    template <typename BOUNDS, typename FUNC>
+        requires std::convertible_to<std::invoke_result_t<BOUNDS &, const OBJ_TYPE &>, BoundaryBox> &&
+                 std::invocable<FUNC &, const Container &>
+    [[nodiscard]] static inline OctreeTuning calibrate(const BoundaryBox &boundary, std::span<const OBJ_TYPE> objects,
+                                                       BOUNDS &&bounds, FUNC &&queries,
+                                                       const float looseness = TIGHT_LOOSENESS,
+                                                       ThreadPool *threadPool = nullptr) noexcept
+    {
+        std::vector<BoundaryBox> boxes;
+        boxes.reserve(objects.size());
+        for (const OBJ_TYPE &object : objects)
+            boxes.emplace_back(bounds(object));
+
+        const OctreeTuning guess = estimate(boundary, boxes, looseness);
+        OctreeTuning best = guess;
+        auto bestTime = std::chrono::steady_clock::duration::max();
+
+        for (int depth = guess.depth - 1; depth <= guess.depth + 1; ++depth)
+        {
+            const int capacity = guess.capacity;
+            for (const int candidate : {capacity / 2, capacity, std::min(capacity * 2, UINT8_MAX)})
+            {
+                if (depth < 0 || depth > DEPTH_LIMIT)
+                    continue;
+
+                const OctreeTuning tuning{static_cast<uint8_t>(candidate), static_cast<uint8_t>(depth)};
+                Container trial(boundary, tuning.capacity, tuning.depth, looseness);
+                trial.insert_bulk(objects, bounds, threadPool);
+
+                for (int run = 0; run < CALIBRATION_RUNS; ++run)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    queries(std::as_const(trial));
+                    const auto time = std::chrono::steady_clock::now() - start;
+
+                    if (time < bestTime)
+                    {
+                        bestTime = time;
+                        best = tuning;
+                    }
+                }
+            }
+        }
+
+        return best;
+    }
+};
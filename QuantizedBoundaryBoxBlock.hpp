@@ -0,0 +1,415 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file QuantizedBoundaryBoxBlock.hpp
+ * @brief Compressed Storage of BoundaryBox Relative to a Frame.
+ *
+ * Drop-in replacement of BoundaryBoxBlock for the octree nodes. Every bound
+ * is stored as an 8 or 16 bit step of a frame, the box of the node, rounded
+ * outwards: a min is rounded down and a max up, so the stored box always
+ * holds the real one and an overlap test never misses a hit. The steps of a
+ * query box are computed once per block and the boxes are then tested 32 or
+ * 64 at once on the integer lanes, with AVX2 or AVX-512BW when enabled.
+ *
+ * The test can report boxes that are within a step of the query without
+ * touching it, the caller refines them with the exact bounds.
+ *
+ * It is a memory trade, not a speed-up: the bounds take a third or a sixth
+ * of the room of the float block, but the searches pay for the steps of the
+ * query and for the refinement of the boxes near its border, and run slower
+ * than on the float block. Use it for trees too large to fit otherwise.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include "BoundaryBox.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+#    include <immintrin.h>
+#endif
+
+template <typename CODE_TYPE = uint16_t> class QuantizedBoundaryBoxBlock {
+    static_assert(std::is_same_v<CODE_TYPE, uint8_t> || std::is_same_v<CODE_TYPE, uint16_t>,
+                  "the bounds are stored on 8 or 16 bits");
+
+private:
+    enum LANE : uint8_t {
+        MIN_X,
+        MIN_Y,
+        MIN_Z,
+        MAX_X,
+        MAX_Y,
+        MAX_Z,
+        LANE_COUNT
+    };
+
+    static constexpr CODE_TYPE TOP = std::numeric_limits<CODE_TYPE>::max();
+    static constexpr size_t GRAIN = 8u; // the capacity is kept a multiple of it
+
+#if defined(__AVX512BW__)
+    static constexpr size_t BATCH = 64u / sizeof(CODE_TYPE);
+#elif defined(__AVX2__)
+    static constexpr size_t BATCH = 32u / sizeof(CODE_TYPE);
+#else
+    static constexpr size_t BATCH = 1u;
+#endif
+
+public:
+    QuantizedBoundaryBoxBlock() = default;
+    QuantizedBoundaryBoxBlock(QuantizedBoundaryBoxBlock &&other) noexcept = default;
+    QuantizedBoundaryBoxBlock &operator=(QuantizedBoundaryBoxBlock &&other) noexcept = default;
+    ~QuantizedBoundaryBoxBlock() = default;
+
+    /**
+     * @brief Set the frame the boxes are stored in, the block must be empty.
+     *
+     * @param open whether the boxes may stick out of the frame, as on the root of a tree. The first and last steps
+     * then only stand for everything below and above the frame, the boxes inside it keep finite bounds.
+     */
+    inline void frame(const BoundaryBox &box, bool open) noexcept
+    {
+        _frameMin = box.getMin();
+        _frameMax = box.getMax();
+        _open = open;
+        _first = open ? 1u : 0u;
+        _last = open ? TOP - 1u : TOP;
+
+        const glm::vec3 size = box.getSize();
+        for (uint8_t axis = 0; axis < 3u; ++axis)
+        {
+            _step[axis] = size[axis] / static_cast<float>(_last - _first);
+            _scale[axis] = _step[axis] > 0.f ? 1.f / _step[axis] : 0.f;
+        }
+    }
+
+    [[nodiscard]] inline size_t size() const noexcept { return _size; }
+    [[nodiscard]] inline bool empty() const noexcept { return _size == 0; }
+    [[nodiscard]] inline size_t capacity() const noexcept { return _capacity; }
+    [[nodiscard]] inline size_t bytes() const noexcept { return _capacity * LANE_COUNT * sizeof(CODE_TYPE); }
+
+    inline void clear() noexcept { _size = 0; }
+
+    inline void reserve(size_t count)
+    {
+        if (count <= _capacity)
+            return;
+
+        const size_t capacity = (std::max(count, _capacity * 2u) + GRAIN - 1u) / GRAIN * GRAIN;
+        std::unique_ptr<CODE_TYPE[]> data = std::make_unique<CODE_TYPE[]>(capacity * LANE_COUNT);
+
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            std::copy_n(this->lane(lane), _size, data.get() + lane * capacity);
+
+        _data = std::move(data);
+        _capacity = capacity;
+    }
+
+    inline void push_back(const BoundaryBox &box)
+    {
+        reserve(_size + 1u);
+        set(_size++, box);
+    }
+
+    /**
+     * @brief Unordered erase, the last box takes the place of the removed one.
+     */
+    inline void swap_pop(size_t index) noexcept
+    {
+        --_size;
+
+        for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+            this->lane(lane)[index] = this->lane(lane)[_size];
+    }
+
+    inline void set(size_t index, const BoundaryBox &box) noexcept
+    {
+        for (uint8_t axis = 0; axis < 3u; ++axis)
+        {
+            lane(MIN_X + axis)[index] = floor_code(box.getMin()[axis], axis);
+            lane(MAX_X + axis)[index] = ceil_code(box.getMax()[axis], axis);
+        }
+    }
+
+    /**
+     * @brief The stored box, which holds the one that was set.
+     */
+    [[nodiscard]] inline BoundaryBox operator[](size_t index) const noexcept
+    {
+        glm::vec3 min, max;
+
+        for (uint8_t axis = 0; axis < 3u; ++axis)
+        {
+            min[axis] = min_value(lane(MIN_X + axis)[index], axis);
+            max[axis] = max_value(lane(MAX_X + axis)[index], axis);
+        }
+
+        return BoundaryBox::fromMinMax(min, max);
+    }
+
+    /**
+     * @brief Call visitor(index) for every box in [first, last) whose stored box overlaps rArea.
+     *
+     * A visitor(index, inside) also learns whether any box the stored one may hold overlaps rArea, only the others
+     * need to be checked against the box that was set.
+     */
+    template <typename FUNC>
+    inline void overlaps(const BoundaryBox &rArea, size_t first, size_t last, FUNC &&visitor) const noexcept
+    {
+        // the boxes overlap along an axis when their min step is at most the last one that starts before the end of
+        // rArea, and their max step at least the first one that ends after its start
+        std::array<CODE_TYPE, LANE_COUNT> bound{};
+
+        for (uint8_t axis = 0; axis < 3u; ++axis)
+        {
+            if (!_open && (rArea.getMax()[axis] < _frameMin[axis] || rArea.getMin()[axis] > _frameMax[axis]))
+                return;
+
+            bound[MIN_X + axis] = floor_code(rArea.getMax()[axis], axis);
+            bound[MAX_X + axis] = ceil_code(rArea.getMin()[axis], axis);
+        }
+
+        // the set box starts before the step after its min step and ends after the step before its max step
+        const auto visit = [this, &bound, &visitor](size_t index) {
+            if constexpr (std::is_invocable_v<FUNC &, size_t, bool>)
+                visitor(index, lane(MIN_X)[index] < bound[MIN_X] && lane(MAX_X)[index] > bound[MAX_X] &&
+                                   lane(MIN_Y)[index] < bound[MIN_Y] && lane(MAX_Y)[index] > bound[MAX_Y] &&
+                                   lane(MIN_Z)[index] < bound[MIN_Z] && lane(MAX_Z)[index] > bound[MAX_Z]);
+            else
+                visitor(index);
+        };
+
+        size_t i = first;
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+        for (; i + BATCH <= last; i += BATCH)
+            visit_mask(batch_mask(bound, [this, i](uint8_t lane) { return this->lane(lane) + i; }), i, visit);
+
+        if (i < last) // the end of the range is copied out, so the lanes need no padding
+        {
+            alignas(64) CODE_TYPE tail[LANE_COUNT][BATCH] = {};
+
+            for (uint8_t lane = 0; lane < LANE_COUNT; ++lane)
+                std::memcpy(tail[lane], this->lane(lane) + i, (last - i) * sizeof(CODE_TYPE));
+
+            const auto mask = batch_mask(bound, [&tail](uint8_t lane) { return &tail[lane][0]; });
+            visit_mask(mask & low_bits<decltype(mask)>(last - i), i, visit);
+            i = last;
+        }
+#endif
+
+        for (; i < last; ++i)
+        {
+            if (lane(MIN_X)[i] <= bound[MIN_X] && lane(MAX_X)[i] >= bound[MAX_X] && lane(MIN_Y)[i] <= bound[MIN_Y] &&
+                lane(MAX_Y)[i] >= bound[MAX_Y] && lane(MIN_Z)[i] <= bound[MIN_Z] && lane(MAX_Z)[i] >= bound[MAX_Z])
+                visit(i);
+        }
+    }
+
+    template <typename FUNC> inline void overlaps(const BoundaryBox &rArea, FUNC &&visitor) const noexcept
+    {
+        overlaps(rArea, 0u, _size, visitor);
+    }
+
+private:
+#if defined(__AVX512BW__)
+    template <typename LANES>
+    [[nodiscard]] static inline uint64_t batch_mask(const std::array<CODE_TYPE, LANE_COUNT> &bound,
+                                                    LANES &&lanes) noexcept
+    {
+        const auto load = [&lanes](uint8_t lane) { return _mm512_loadu_si512(lanes(lane)); };
+
+        if constexpr (sizeof(CODE_TYPE) == 1u)
+        {
+            __mmask64 mask = _mm512_cmple_epu8_mask(load(MIN_X), _mm512_set1_epi8(static_cast<char>(bound[MIN_X])));
+            mask = _mm512_mask_cmpge_epu8_mask(mask, load(MAX_X), _mm512_set1_epi8(static_cast<char>(bound[MAX_X])));
+            mask = _mm512_mask_cmple_epu8_mask(mask, load(MIN_Y), _mm512_set1_epi8(static_cast<char>(bound[MIN_Y])));
+            mask = _mm512_mask_cmpge_epu8_mask(mask, load(MAX_Y), _mm512_set1_epi8(static_cast<char>(bound[MAX_Y])));
+            mask = _mm512_mask_cmple_epu8_mask(mask, load(MIN_Z), _mm512_set1_epi8(static_cast<char>(bound[MIN_Z])));
+            mask = _mm512_mask_cmpge_epu8_mask(mask, load(MAX_Z), _mm512_set1_epi8(static_cast<char>(bound[MAX_Z])));
+            return mask;
+        }
+        else
+        {
+            __mmask32 mask = _mm512_cmple_epu16_mask(load(MIN_X), _mm512_set1_epi16(static_cast<short>(bound[MIN_X])));
+            mask = _mm512_mask_cmpge_epu16_mask(mask, load(MAX_X), _mm512_set1_epi16(static_cast<short>(bound[MAX_X])));
+            mask = _mm512_mask_cmple_epu16_mask(mask, load(MIN_Y), _mm512_set1_epi16(static_cast<short>(bound[MIN_Y])));
+            mask = _mm512_mask_cmpge_epu16_mask(mask, load(MAX_Y), _mm512_set1_epi16(static_cast<short>(bound[MAX_Y])));
+            mask = _mm512_mask_cmple_epu16_mask(mask, load(MIN_Z), _mm512_set1_epi16(static_cast<short>(bound[MIN_Z])));
+            mask = _mm512_mask_cmpge_epu16_mask(mask, load(MAX_Z), _mm512_set1_epi16(static_cast<short>(bound[MAX_Z])));
+            return mask;
+        }
+    }
+#elif defined(__AVX2__)
+    /**
+     * @brief One bit per byte of the batch, set for the bytes of the boxes that pass, AVX2 has no unsigned compare so
+     * a <= b is tested as min(a, b) == a.
+     */
+    template <typename LANES>
+    [[nodiscard]] static inline uint32_t batch_mask(const std::array<CODE_TYPE, LANE_COUNT> &bound,
+                                                    LANES &&lanes) noexcept
+    {
+        const auto load = [&lanes](uint8_t lane) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lanes(lane)));
+        };
+
+        __m256i hit = _mm256_set1_epi8(-1);
+
+        for (uint8_t axis = 0; axis < 3u; ++axis)
+        {
+            const __m256i min = load(MIN_X + axis);
+            const __m256i max = load(MAX_X + axis);
+
+            if constexpr (sizeof(CODE_TYPE) == 1u)
+            {
+                const __m256i below = _mm256_set1_epi8(static_cast<char>(bound[MIN_X + axis]));
+                const __m256i above = _mm256_set1_epi8(static_cast<char>(bound[MAX_X + axis]));
+                hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(_mm256_min_epu8(min, below), min));
+                hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(_mm256_max_epu8(max, above), max));
+            }
+            else
+            {
+                const __m256i below = _mm256_set1_epi16(static_cast<short>(bound[MIN_X + axis]));
+                const __m256i above = _mm256_set1_epi16(static_cast<short>(bound[MAX_X + axis]));
+                hit = _mm256_and_si256(hit, _mm256_cmpeq_epi16(_mm256_min_epu16(min, below), min));
+                hit = _mm256_and_si256(hit, _mm256_cmpeq_epi16(_mm256_max_epu16(max, above), max));
+            }
+        }
+
+        return static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+    }
+#endif
+
+    /**
+     * @brief Visit the boxes set in mask, where each box takes the bits of its bytes with AVX2 and a single bit with
+     * AVX-512.
+     */
+    template <typename MASK, typename FUNC>
+    static inline void visit_mask(MASK mask, size_t base, const FUNC &visitor) noexcept
+    {
+#if defined(__AVX512BW__)
+        constexpr uint8_t BITS = 1u;
+#else
+        constexpr uint8_t BITS = sizeof(CODE_TYPE);
+#endif
+
+        while (mask)
+        {
+            const int bit = std::countr_zero(mask);
+            visitor(base + static_cast<size_t>(bit) / BITS);
+            mask &= static_cast<MASK>(~(((MASK{1} << BITS) - 1u) << bit));
+        }
+    }
+
+    /**
+     * @brief Mask of the bits of the first count boxes of a batch.
+     */
+    template <typename MASK> [[nodiscard]] static constexpr MASK low_bits(size_t count) noexcept
+    {
+#if !defined(__AVX512BW__)
+        count *= sizeof(CODE_TYPE); // one bit per byte
+#endif
+        return count >= sizeof(MASK) * 8u ? static_cast<MASK>(~MASK{0}) : static_cast<MASK>((MASK{1} << count) - 1u);
+    }
+
+    /**
+     * @brief Highest step whose value is at most value.
+     */
+    [[nodiscard]] inline CODE_TYPE floor_code(float value, uint8_t axis) const noexcept
+    {
+        if (value < _frameMin[axis])
+            return 0u;
+        if (!(value > _frameMin[axis]))
+            return _first;
+        if (value >= _frameMax[axis])
+            return _last;
+
+        auto code = static_cast<CODE_TYPE>(_first + std::clamp((value - _frameMin[axis]) * _scale[axis], 0.f,
+                                                               static_cast<float>(_last - _first)));
+        while (code > _first && min_value(code, axis) > value)
+            --code;
+        return code;
+    }
+
+    /**
+     * @brief Lowest step whose value is at least value.
+     */
+    [[nodiscard]] inline CODE_TYPE ceil_code(float value, uint8_t axis) const noexcept
+    {
+        if (value > _frameMax[axis])
+            return TOP;
+        if (!(value < _frameMax[axis]))
+            return _last;
+        if (value <= _frameMin[axis])
+            return _first;
+
+        auto code = static_cast<CODE_TYPE>(
+            _first + std::clamp(std::ceil((value - _frameMin[axis]) * _scale[axis]), 0.f,
+                                static_cast<float>(_last - _first)));
+        while (code < _last && max_value(code, axis) < value)
+            ++code;
+        return code;
+    }
+
+    [[nodiscard]] inline float min_value(CODE_TYPE code, uint8_t axis) const noexcept
+    {
+        if (code < _first)
+            return std::numeric_limits<float>::lowest();
+        if (code >= _last)
+            return _frameMax[axis];
+        return _frameMin[axis] + static_cast<float>(code - _first) * _step[axis];
+    }
+
+    [[nodiscard]] inline float max_value(CODE_TYPE code, uint8_t axis) const noexcept
+    {
+        if (code > _last)
+            return std::numeric_limits<float>::max();
+        if (code == _last)
+            return _frameMax[axis];
+        if (code <= _first)
+            return _frameMin[axis];
+        return _frameMin[axis] + static_cast<float>(code - _first) * _step[axis];
+    }
+
+    [[nodiscard]] inline CODE_TYPE *lane(uint8_t lane) noexcept { return _data.get() + lane * _capacity; }
+    [[nodiscard]] inline const CODE_TYPE *lane(uint8_t lane) const noexcept { return _data.get() + lane * _capacity; }
+
+private:
+    std::unique_ptr<CODE_TYPE[]> _data;
+    size_t _size = 0;
+    size_t _capacity = 0;
+
+    glm::vec3 _frameMin{0.f};
+    glm::vec3 _frameMax{0.f};
+    glm::vec3 _step{0.f};  // size of a step along every axis
+    glm::vec3 _scale{0.f}; // steps per unit along every axis
+    CODE_TYPE _first = 1u; // steps of the borders of the frame, the ones out of them stand for beyond it
+    CODE_TYPE _last = TOP - 1u;
+    bool _open = true;
+};
@@ -442,6 +442,9 @@ private:
         init_cornell_box();
 #endif
 
+        // indexer la scène dans l'octree utilisé par raycast
+        build_scene_tree();
+
         // itération sur les rangées de pixels
         for (uint16_t y = 0u; y < _IMAGE_HEIGHT; ++y)
         {
@@ -637,35 +640,62 @@ private:
         return Vector();
     }
 
-    bool raycast(const Ray &ray, double &distance, uint32_t &id)
+    // boîte englobante d'une géométrie, les sphères sont centrées sur leur position
+    [[nodiscard]] inline BoundaryBox bounds(const SpatialObject &object) const noexcept
     {
-        // variable temporaire pour la distance d'une intersection entre un rayon et une sphère
-        double d = 0.0;
+        if (object.type == SpatialObject::Type::CUBE)
+            return object.getBoundingBox();
 
-        // initialiser la distance à une valeur suffisamment éloignée pour qu'on la considère comme l'infinie
-        distance = std::numeric_limits<double>::max();
-        double infinity = distance;
+        // rayon du test d'intersection, un peu agrandi pour que l'arrondi en float ne coupe jamais une intersection
+        const float radius = static_cast<float>(sqrt(object.radius.x * object.radius.y)) * (1.f + 1e-6f);
 
-        // nombre d'éléments dans la scène
-        uint32_t n = static_cast<uint32_t>(_scene.size());
+        return BoundaryBox(object.position - glm::vec3(radius), glm::vec3(2.f * radius));
+    }
 
-        // parcourir tous les éléments de la scène
-        for (uint32_t index = 0; index < n; ++index)
-        {
-            // test d'intersection entre le rayon et la géométrie à cet index
-            d = intersect(ray, _scene[index]);
+    void build_scene_tree()
+    {
+        std::vector<OctreeBulkItem<uint32_t>> items;
+        items.reserve(_scene.size());
 
-            // valider s'il y a eu intersection et si la distance est inférieure aux autres intersections
-            if (d && d < distance)
-            {
-                // nouvelle valeur courante de la distance et l'index de l'intersection la plus rapprochée de la caméra
-                distance = d;
-                id = index;
-            }
+        glm::vec3 min(std::numeric_limits<float>::max());
+        glm::vec3 max(std::numeric_limits<float>::lowest());
+
+        for (uint32_t index = 0; index < _scene.size(); ++index)
+        {
+            items.push_back({index, bounds(_scene[index])});
+            min = glm::min(min, items.back().itemsize.getMin());
+            max = glm::max(max, items.back().itemsize.getMax());
         }
 
-        // il y a eu intersection si la distance est plus petite que l'infini
-        return distance < infinity;
+        _sceneTree.clear();
+
+        if (items.empty())
+            return;
+
+        _sceneTree.resize(BoundaryBox::fromMinMax(min, max));
+        _sceneTree.insert_bulk(std::span(items));
+    }
+
+    bool raycast(const Ray &ray, double &distance, uint32_t &id)
+    {
+        const glm::vec3 origin(ray.origin.x, ray.origin.y, ray.origin.z);
+        const glm::vec3 direction(ray.direction.x, ray.direction.y, ray.direction.z);
+
+        // parcours de l'octree dans l'ordre du rayon, le test exact n'est fait que pour les boîtes traversées
+        const auto hit = _sceneTree.raycast(origin, direction, std::numeric_limits<float>::infinity(),
+                                            [this, &ray](uint32_t index, float) {
+                                                const double d = intersect(ray, _scene[index]);
+                                                return d ? static_cast<float>(d) : std::numeric_limits<float>::infinity();
+                                            });
+
+        // il n'y a pas eu d'intersection
+        if (!hit)
+            return false;
+
+        // distance exacte de l'intersection la plus rapprochée
+        id = hit->item;
+        distance = intersect(ray, _scene[id]);
+        return true;
     }
 
     void post_render(sf::RenderWindow &window) noexcept
@@ -704,6 +734,7 @@ private:
 
     WorldPartition _worldPartition;
     std::vector<SpatialObject> _scene;
+    DynamicOctree<uint32_t> _sceneTree{BoundaryBox({0, 0, 0}, {1, 1, 1})};
 
     // framebuffer de SFML
     sf::Texture _texture;
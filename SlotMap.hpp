@@ -0,0 +1,178 @@
+/**************************************************************************
+ * Optimizing v0.0.0
+ *
+ * Optimizing is a C/CPP software package, part of the Laplace-Project.
+ * It is designed to provide a set of tools and utilities for optimizing
+ * various aspects of software development, including performance,
+ * memory usage, and code organization.
+ *
+ * This file is part of the Optimizing project that is under Anti-NN License.
+ * https://github.com/MasterLaplace/Anti-NN_LICENSE
+ * Copyright © 2025 by @MasterLaplace, All rights reserved.
+ *
+ * Optimizing is a free software: you can redistribute it and/or modify
+ * it under the terms of the Anti-NN License as published by MasterLaplace.
+ * See the Anti-NN License for more details.
+ *
+ * @file SlotMap.hpp
+ * @brief Dense Storage with Stable Generational Handles.
+ *
+ * The values are packed in a single vector, so walking all of them is a
+ * linear read. Every value is reached through a slot that never moves: the
+ * slot keeps the position of its value when erasing another value moves it,
+ * and a generation that the handles must match, so a handle to an erased
+ * value is told apart from the value that reuses its slot.
+ *
+ * @author @MasterLaplace
+ * @version 0.0.0
+ * @date 2025-04-03
+ **************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Stable reference to a value of a SlotMap, stale once the value is erased.
+ */
+struct SlotHandle {
+    uint32_t index = std::numeric_limits<uint32_t>::max(); // slot of the value
+    uint32_t generation = 0;
+
+    [[nodiscard]] inline bool operator==(const SlotHandle &other) const noexcept = default;
+};
+
+template <typename VALUE_TYPE> class SlotMap {
+public:
+    using iterator = typename std::vector<VALUE_TYPE>::iterator;
+    using const_iterator = typename std::vector<VALUE_TYPE>::const_iterator;
+
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+public:
+    template <typename... Args> inline SlotHandle emplace(Args &&...args)
+    {
+        uint32_t index = _free;
+
+        if (index == NO_SLOT)
+        {
+            index = static_cast<uint32_t>(_slots.size());
+            _slots.push_back({});
+        }
+        else
+            _free = _slots[index].position;
+
+        _slots[index].position = static_cast<uint32_t>(_values.size());
+        _values.emplace_back(std::forward<Args>(args)...);
+        _owners.push_back(index);
+        return {index, _slots[index].generation};
+    }
+
+    /**
+     * @brief Erase a value, the last value takes its place. Does nothing for a stale handle.
+     */
+    inline void erase(const SlotHandle &handle) noexcept
+    {
+        if (!contains(handle))
+            return;
+
+        Slot &slot = _slots[handle.index];
+        const uint32_t last = _owners.back();
+
+        if (last != handle.index)
+        {
+            _values[slot.position] = std::move(_values.back());
+            _owners[slot.position] = last;
+            _slots[last].position = slot.position;
+        }
+
+        _values.pop_back();
+        _owners.pop_back();
+
+        ++slot.generation;
+        slot.position = std::exchange(_free, handle.index);
+    }
+
+    inline void clear() noexcept
+    {
+        for (const uint32_t index : _owners)
+        {
+            ++_slots[index].generation;
+            _slots[index].position = std::exchange(_free, index);
+        }
+
+        _values.clear();
+        _owners.clear();
+    }
+
+    inline void reserve(size_t count)
+    {
+        _values.reserve(count);
+        _owners.reserve(count);
+        _slots.reserve(count);
+    }
+
+    [[nodiscard]] inline bool contains(const SlotHandle &handle) const noexcept
+    {
+        // erasing bumps the generation, a free slot never matches a handle that was given out
+        return handle.index < _slots.size() && _slots[handle.index].generation == handle.generation;
+    }
+
+    [[nodiscard]] inline VALUE_TYPE &operator[](const SlotHandle &handle) noexcept { return at(handle.index); }
+    [[nodiscard]] inline const VALUE_TYPE &operator[](const SlotHandle &handle) const noexcept
+    {
+        return at(handle.index);
+    }
+
+    /**
+     * @brief Value of a live slot, without the generation check.
+     */
+    [[nodiscard]] inline VALUE_TYPE &at(uint32_t index) noexcept { return _values[_slots[index].position]; }
+    [[nodiscard]] inline const VALUE_TYPE &at(uint32_t index) const noexcept
+    {
+        return _values[_slots[index].position];
+    }
+
+    /**
+     * @brief Handle of the value in a live slot.
+     */
+    [[nodiscard]] inline SlotHandle handle(uint32_t index) const noexcept { return {index, _slots[index].generation}; }
+
+    /**
+     * @brief Handle of the value at a position of the dense storage.
+     */
+    [[nodiscard]] inline SlotHandle handle_at(size_t position) const noexcept { return handle(_owners[position]); }
+
+    [[nodiscard]] inline size_t size() const noexcept { return _values.size(); }
+    [[nodiscard]] inline bool empty() const noexcept { return _values.empty(); }
+
+    /**
+     * @brief Memory held by the values and the slots, up to their capacity.
+     */
+    [[nodiscard]] inline size_t bytes() const noexcept
+    {
+        return _values.capacity() * sizeof(VALUE_TYPE) + _owners.capacity() * sizeof(uint32_t) +
+               _slots.capacity() * sizeof(Slot);
+    }
+
+    [[nodiscard]] inline iterator begin() noexcept { return _values.begin(); }
+    [[nodiscard]] inline iterator end() noexcept { return _values.end(); }
+    [[nodiscard]] inline const_iterator begin() const noexcept { return _values.begin(); }
+    [[nodiscard]] inline const_iterator end() const noexcept { return _values.end(); }
+
+private:
+    struct Slot {
+        uint32_t position = 0; // of the value in _values, or the next free slot once erased
+        uint32_t generation = 0;
+    };
+
+private:
+    std::vector<VALUE_TYPE> _values;
+    std::vector<uint32_t> _owners; // slot of every value, same order
+    std::vector<Slot> _slots;
+    uint32_t _free = NO_SLOT; // first free slot, the others follow through their position
+};
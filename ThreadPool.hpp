@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -48,6 +52,47 @@ public:
         return res;
     }
 
+    /**
+     * @brief Run body(i) for every i in [0, count) on the workers and on the calling thread, and return once all
+     * of them are done.
+     *
+     * The caller takes part in the loop and only waits for the indices a worker already started, so it is safe to
+     * call from inside a task even when every worker is busy.
+     */
+    template <class F> void parallel_for(size_t count, F &&body)
+    {
+        struct State {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+        };
+
+        auto state = std::make_shared<State>();
+        auto run = [state, count, &body] {
+            for (size_t i; (i = state->next.fetch_add(1)) < count;)
+            {
+                body(i);
+                if (state->done.fetch_add(1) + 1 == count)
+                    state->done.notify_all();
+            }
+        };
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+
+            if (!stop)
+            {
+                for (size_t i = 1; i < std::min(count, workers.size() + 1); ++i)
+                    tasks.emplace(run);
+            }
+        }
+        condition.notify_all();
+
+        run();
+
+        for (size_t done = state->done.load(); done < count; done = state->done.load())
+            state->done.wait(done);
+    }
+
     ~ThreadPool()
     {
         {
@@ -67,3 +112,15 @@ private:
     std::condition_variable condition;
     bool stop;
 };
+
+/**
+ * @brief Same as ThreadPool::parallel_for, the loop runs on the calling thread alone when pool is null.
+ */
+template <class F> void parallel_for(ThreadPool *pool, size_t count, F &&body)
+{
+    if (pool)
+        return pool->parallel_for(count, body);
+
+    for (size_t i = 0; i < count; ++i)
+        body(i);
+}
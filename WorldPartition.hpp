@@ -24,9 +24,14 @@
 
 #pragma once
 
+#include "BakedOctree.hpp"
 #include "DynamicOctree.hpp"
+#include "LinearOctree.hpp"
+#include "OctreeTuner.hpp"
 #include "ThreadPool.hpp"
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -65,56 +70,255 @@ template <> struct hash<glm::ivec2> {
     return dis(gen);
 };
 
-class Partition {
+/**
+ * @brief A cell of the world, its objects are only indexed while the cell is loaded.
+ *
+ * The queries run on the last snapshot of the index published by the cell, without taking its lock. A load publishes
+ * one right away, moves only publish one when a reader asked for a view since the previous one, at most once per
+ * snapshot period. When every object moves, each snapshot copies the whole index.
+ *
+ * A cell can also map a baked file, a static layer queried in place alongside the loaded objects. The depth and
+ * capacity of a DynamicOctreeContainer index are tuned for the objects of the cell every time it is loaded.
+ *
+ * @tparam SPATIAL_CONTAINER spatial index of the loaded objects, either DynamicOctreeContainer or
+ * LinearOctreeContainer.
+ */
+template <typename SPATIAL_CONTAINER = DynamicOctreeContainer<SpatialObject>> class BasicPartition {
 public:
-    Partition(const glm::vec3 &pos, const glm::vec3 &size)
+    using Container = SPATIAL_CONTAINER;
+
+    BasicPartition(const glm::vec3 &pos, const glm::vec3 &size)
         : _pos(pos), _size(size), _octree(BoundaryBox(pos, size), MAX_CAPACITY, MAX_DEPTH)
     {
     }
-    ~Partition() = default;
+    ~BasicPartition() = default;
 
-    void insert(const SpatialObject &obj) { _objects.emplace_back(obj); }
+    /**
+     * @brief Add an object to the cell, straight into its index while it is loaded.
+     */
+    void insert(const SpatialObject &obj)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_loaded)
+            _octree.insert(obj, obj.getBoundingBox());
+        else
+            _objects.emplace_back(obj);
+    }
 
-    void load_data()
+    /**
+     * @brief Index the objects of the cell, the octree is built in one pass on threadPool when one is given.
+     */
+    void load_data(ThreadPool *threadPool = nullptr)
     {
-        if (_objects.empty() || (_loaded && _objects.size() == _octree.size()))
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_bakedPath.empty() && !_baked.load())
+            _baked.store(BakedOctree<SpatialObject>::map(_bakedPath));
+
+        // a layer baked from this cell already holds its objects, they are queried from the mapping instead
+        if (!_loaded && covers(_baked.load().get()))
+            return;
+
+        if (_loaded || _objects.empty())
             return;
         _loaded = true;
 
-        for (const auto &obj : _objects)
-            _octree.insert(obj, BoundaryBox(obj.position, obj.size));
+        tune(threadPool);
+        _octree.insert_bulk(std::span<const SpatialObject>(_objects),
+                            [](const SpatialObject &obj) { return obj.getBoundingBox(); }, threadPool);
+        _objects.clear();
+        publish(true);
 
         std::cout << "Cellule " << _pos.x << " " << _pos.z << " chargée." << std::endl;
     }
 
     void unload_data()
     {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _baked.store(nullptr);
         if (!_loaded)
             return;
 
-        _loaded = false;
-        _octree.clear();
+        drop_index();
         std::cout << "Cellule " << _pos.x << " " << _pos.z << " déchargée." << std::endl;
     }
 
-    void draw(sf::RenderWindow &window, const glm::vec3 &player_pos)
+    /**
+     * @brief Integrate the velocity of every loaded object, only the objects that left their octree node move in it.
+     *
+     * @return the objects whose position left the cell, taken out of it for the caller to hand to the cell they are
+     * now in, see WorldPartition::update_objects().
+     */
+    std::vector<SpatialObject> update(float deltaTime)
     {
-        if (!_loaded || _objects.empty())
-            return;
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<SpatialObject> leaving;
+        if (!_loaded)
+            return leaving;
+
+        bool left = false;
+        _octree.relocate_all([this, deltaTime, &left](SpatialObject &obj) {
+            obj.position += obj.velocity * deltaTime;
+            left |= !owns(obj.position);
+            return obj.getBoundingBox();
+        });
+
+        if (left)
+        {
+            std::vector<typename SPATIAL_CONTAINER::Handle> handles;
+            for (auto it = _octree.begin(); it != _octree.end(); ++it)
+            {
+                if (owns(it->item.position))
+                    continue;
+
+                leaving.emplace_back(it->item);
+                handles.emplace_back(_octree.handle(it));
+            }
+            _octree.remove_batch(handles);
+        }
+
+        publish(false);
+        return leaving;
+    }
+
+    /**
+     * @brief Tune the index at every load by timing queries(index) on a few candidate trees, see
+     * OctreeTuner::calibrate(), instead of estimating it from the objects alone. An empty function goes back to the
+     * estimate.
+     */
+    void calibrate_with(std::function<void(const SPATIAL_CONTAINER &)> queries)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _calibration = std::move(queries);
+    }
+
+    /**
+     * @brief Publish a snapshot after the moves at most once per period, the readers see the objects up to a period
+     * late. Zero publishes one after every update() a reader asked for a view before.
+     */
+    void snapshot_every(std::chrono::steady_clock::duration period)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _snapshotPeriod = period;
+    }
+
+    /**
+     * @brief The last published view of the index, nullptr while the cell is not loaded. It stays valid for as long as
+     * the caller holds it, and asks the cell for a newer one after the next moves.
+     */
+    [[nodiscard]] std::shared_ptr<const typename SPATIAL_CONTAINER::Snapshot> snapshot() const noexcept
+    {
+        _wanted.store(true, std::memory_order_relaxed);
+        return _snapshot.load();
+    }
 
+    /**
+     * @brief Write the loaded objects and their octree to path, to be mapped later with load_baked().
+     *
+     * @return false when the cell is not loaded or the file cannot be written.
+     */
+    [[nodiscard]] bool bake(const std::filesystem::path &path) const
+    {
+        const auto snapshot = _snapshot.load();
+        return snapshot && BakedOctree<SpatialObject>::bake(path, *snapshot);
+    }
+
+    /**
+     * @brief Map a baked file as the static layer of the cell. Its objects are queried straight from the mapping and
+     * never move, the file is unmapped with the cell and mapped again by load_data().
+     *
+     * A file baked from this cell covers it: load_data() then leaves the objects of the cell out of the index, so they
+     * are neither inserted again nor drawn twice.
+     *
+     * @return false when the file cannot be mapped.
+     */
+    [[nodiscard]] bool load_baked(const std::filesystem::path &path)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::shared_ptr<const BakedOctree<SpatialObject>> baked = BakedOctree<SpatialObject>::map(path);
+        if (!baked)
+            return false;
+
+        if (_loaded && covers(baked.get()))
+            drop_index();
+
+        _bakedPath = path;
+        _baked.store(std::move(baked));
+        return true;
+    }
+
+    /**
+     * @brief The count loaded or baked objects closest to point, nearest first.
+     */
+    template <typename FILTER = OctreeAcceptAll>
+    [[nodiscard]] std::vector<OctreeNeighbour<SpatialObject>> nearest(const glm::vec3 &point, size_t count,
+                                                                      float maxDistance, FILTER &&filter) const
+    {
+        std::vector<OctreeNeighbour<SpatialObject>> found;
+
+        if (const auto snapshot = this->snapshot())
+            found = snapshot->nearest(point, count, maxDistance, filter);
+
+        if (const auto baked = _baked.load())
+        {
+            const float limit = found.size() == count ? std::sqrt(found.back().distance2) : maxDistance;
+            const std::vector<OctreeNeighbour<SpatialObject>> near = baked->nearest(point, count, limit, filter);
+            const size_t middle = found.size();
+
+            found.insert(found.end(), near.begin(), near.end());
+            std::inplace_merge(found.begin(), found.begin() + middle, found.end(),
+                               [](const auto &a, const auto &b) { return a.distance2 < b.distance2; });
+            found.resize(std::min(found.size(), count));
+        }
+
+        return found;
+    }
+
+    /**
+     * @brief Report the loaded objects that entered or left area since the previous search with query, see
+     * DynamicOctreeContainer::search(). The objects of a cell that is unloaded are reported as left.
+     */
+    template <typename QUERY, typename AREA, typename ENTER, typename EXIT>
+        requires requires(SPATIAL_CONTAINER &octree, QUERY &query, const AREA &area, ENTER &enter, EXIT &exit) {
+            octree.search(query, area, enter, exit);
+        }
+    void search(QUERY &query, const AREA &area, ENTER &&enter, EXIT &&exit)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _octree.search(query, area, enter, exit);
+    }
+
+    void draw(sf::RenderWindow &window, const glm::vec3 &player_pos)
+    {
         glm::vec3 size{50, 10, 50};
-        BoundaryBox boundaryBox(size * -0.5f + player_pos, size);
+        draw(window, BoundaryBox(size * -0.5f + player_pos, size));
+    }
+
+    /**
+     * @brief Draw the loaded objects that overlap area, an axis-aligned box or a camera frustum.
+     */
+    template <typename AREA>
+        requires std::same_as<AREA, BoundaryBox> || std::same_as<AREA, Frustum>
+    void draw(sf::RenderWindow &window, const AREA &area)
+    {
+        const auto snapshot = this->snapshot();
+        const auto baked = _baked.load();
+        if (!snapshot && !baked)
+            return;
 
         DEBUG_LINE(auto start = std::chrono::high_resolution_clock::now());
-        for (const auto &obj : _octree.search(boundaryBox))
-        {
+        const auto drawObject = [&](const SpatialObject &obj) {
             sf::RectangleShape rect;
-            rect.setPosition({obj->item.position.x, obj->item.position.z});
-            rect.setSize({obj->item.size.x, obj->item.size.z});
-            rect.setFillColor(sf::Color(obj->item.colour.r, obj->item.colour.g, obj->item.colour.b, obj->item.colour.a));
+            rect.setPosition({obj.position.x, obj.position.z});
+            rect.setSize({obj.size.x, obj.size.z});
+            rect.setFillColor(sf::Color(obj.colour.r, obj.colour.g, obj.colour.b, obj.colour.a));
             window.draw(rect);
             DEBUG_LINE(++_objCount);
-        }
+        };
+
+        if (snapshot)
+            snapshot->search(area, drawObject);
+        if (baked)
+            baked->search(area, drawObject);
 
         sf::RectangleShape rect;
         rect.setPosition({_pos.x, _pos.z});
@@ -134,34 +338,139 @@ public:
             logFile << "OctTree: " << _objCount << " objects displayed in " << duration.count() << " seconds\n";
         }
 
-        _octree.draw(window, boundaryBox);
+        if constexpr (std::same_as<AREA, BoundaryBox>)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _octree.draw(window, area);
+        }
 
         _objCount = 0;
 #endif
     }
 
+    /**
+     * @brief Shape and memory of the index of the loaded objects, see DynamicOctreeContainer::stats().
+     */
+    [[nodiscard]] OctreeStats stats()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _octree.stats();
+    }
+
     void getObjects(std::vector<SpatialObject> &objects)
     {
+        std::lock_guard<std::mutex> lock(_mutex);
         if (!_loaded)
             return;
 
-        objects.reserve(objects.size() + _objects.size());
-        objects.insert(objects.end(), _objects.begin(), _objects.end());
+        objects.reserve(objects.size() + _octree.size());
+        for (auto it = _octree.begin(); it != _octree.end(); ++it)
+            objects.emplace_back(it->item);
     }
 
     [[nodiscard]] inline const glm::vec3 &getPosition() const noexcept { return _pos; }
     [[nodiscard]] inline const glm::vec3 &getSize() const noexcept { return _size; }
     [[nodiscard]] inline bool isLoaded() const noexcept { return _loaded; }
+    [[nodiscard]] inline bool isBaked() const noexcept { return _baked.load() != nullptr; }
+
+private:
+    /**
+     * @brief Whether baked was written from this cell, with at least as many objects as it holds.
+     */
+    [[nodiscard]] bool covers(const BakedOctree<SpatialObject> *baked) const noexcept
+    {
+        return baked && baked->boundary() == _octree.boundary() && baked->size() >= _objects.size() + _octree.size();
+    }
+
+    /**
+     * @brief Whether position is in the cell, rounded like WorldPartition::grid_of() so that an object that left a
+     * cell is never handed back to it.
+     */
+    [[nodiscard]] bool owns(const glm::vec3 &position) const noexcept
+    {
+        return std::floor(position.x / _size.x) == std::floor(_pos.x / _size.x) &&
+               std::floor(position.z / _size.z) == std::floor(_pos.z / _size.z);
+    }
+
+    /**
+     * @brief Store a new snapshot of the index when forced, or when a reader wants one and the period has elapsed.
+     */
+    void publish(bool force)
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (!force && (!_wanted.load(std::memory_order_relaxed) || now - _published < _snapshotPeriod))
+            return;
+
+        // the nodes that changed since the last snapshot taken are copied, however many updates ago it was
+        _wanted.store(false, std::memory_order_relaxed);
+        _published = now;
+        _snapshot.store(_octree.snapshot());
+    }
+
+    /**
+     * @brief Empty the index of the loaded objects, the positions they reached are kept for the next load.
+     */
+    void drop_index()
+    {
+        _loaded = false;
+        _snapshot.store(nullptr);
+
+        _objects.reserve(_octree.size());
+        for (auto it = _octree.begin(); it != _octree.end(); ++it)
+            _objects.emplace_back(it->item);
+
+        _octree.clear();
+    }
+
+    /**
+     * @brief Rebuild the empty index with the depth and capacity that suit the objects of the cell.
+     */
+    void tune(ThreadPool *threadPool)
+    {
+        if constexpr (requires { _octree.reconfigure(uint8_t{}, uint8_t{}); })
+        {
+            using Tuner = OctreeTuner<SPATIAL_CONTAINER>;
+            const auto bounds = [](const SpatialObject &obj) { return obj.getBoundingBox(); };
+            OctreeTuning tuning;
+
+            if (_calibration)
+                tuning = Tuner::calibrate(_octree.boundary(), std::span<const SpatialObject>(_objects), bounds,
+                                          _calibration, _octree.looseness(), threadPool);
+            else
+            {
+                std::vector<BoundaryBox> boxes;
+                boxes.reserve(_objects.size());
+                for (const SpatialObject &obj : _objects)
+                    boxes.emplace_back(bounds(obj));
+
+                tuning = Tuner::estimate(_octree.boundary(), boxes, _octree.looseness());
+            }
+
+            if (tuning.capacity != _octree.capacity() || tuning.depth != _octree.depth())
+                _octree.reconfigure(tuning.capacity, tuning.depth, _octree.looseness());
+        }
+    }
 
 private:
     glm::vec3 _pos;
     glm::vec3 _size;
     std::vector<SpatialObject> _objects;
-    DynamicOctreeContainer<SpatialObject> _octree;
+    SPATIAL_CONTAINER _octree;
+    std::atomic<std::shared_ptr<const typename SPATIAL_CONTAINER::Snapshot>> _snapshot;
+    mutable std::atomic<bool> _wanted = false;             // a reader took a view since the last snapshot
+    std::chrono::steady_clock::duration _snapshotPeriod{}; // shortest time between two snapshots of moves
+    std::chrono::steady_clock::time_point _published{};
+    std::filesystem::path _bakedPath;
+    std::atomic<std::shared_ptr<const BakedOctree<SpatialObject>>> _baked; // unmapped with its last reader
+    std::function<void(const SPATIAL_CONTAINER &)> _calibration;           // query mix timed by tune()
+    std::mutex _mutex;
     DEBUG_LINE(size_t _objCount = 0);
-    bool _loaded = false;
+    std::atomic<bool> _loaded = false;
 };
 
+using Partition = BasicPartition<DynamicQuadtreeContainer<SpatialObject>>; // the cells are unbounded along y
+
 class WorldPartition {
 public:
     WorldPartition() : _threadPool(std::thread::hardware_concurrency()) {}
@@ -170,30 +479,29 @@ public:
     {
         std::lock_guard<std::mutex> lock(_mutex);
         for (const auto &obj : _objects)
-        {
-            glm::ivec2 grid = {static_cast<int>(obj.position.x / _size.x), static_cast<int>(obj.position.z / _size.z)};
-
-            if (_cells.find(grid) == _cells.end())
-                _cells[grid] = std::make_shared<Partition>(glm::vec3(grid.x * _size.x, 0, grid.y * _size.z), _size);
-
-            _cells[grid]->insert(obj);
-        }
+            cell(grid_of(obj.position))->insert(obj);
     }
 
     void load_partition(glm::ivec2 grid)
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        if (_cells.find(grid) == _cells.end())
-            _cells[grid] = std::make_shared<Partition>(glm::vec3(grid.x * _size.x, 0, grid.y * _size.z), _size);
-
-        _threadPool.enqueue(&Partition::load_data, _cells[grid]);
+        _threadPool.enqueue(&Partition::load_data, cell(grid), &_threadPool);
     }
 
     void unload_partition(const std::pair<glm::ivec2, std::shared_ptr<Partition>> &cell) { cell.second->unload_data(); }
 
+    /**
+     * @brief Map a baked file, written by Partition::bake(), as the static layer of the cell at grid.
+     */
+    [[nodiscard]] bool load_baked(glm::ivec2 grid, const std::filesystem::path &path)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return cell(grid)->load_baked(path);
+    }
+
     void update(glm::vec3 player_pos)
     {
-        glm::ivec2 player_grid = {static_cast<int>(player_pos.x / _size.x), static_cast<int>(player_pos.z / _size.z)};
+        glm::ivec2 player_grid = grid_of(player_pos);
 
         for (int x = player_grid.x - 1; x <= player_grid.x + 1; ++x)
         {
@@ -212,13 +520,136 @@ public:
         }
     }
 
-    void draw(sf::RenderWindow &window, const glm::vec3 &player_pos)
+    /**
+     * @brief Calibrate the index of every cell, the ones created later included, on queries, see
+     * Partition::calibrate_with().
+     */
+    void calibrate_with(const std::function<void(const Partition::Container &)> &queries)
     {
         std::lock_guard<std::mutex> lock(_mutex);
+        _calibration = queries;
 
         for (const auto &cell : _cells)
+            cell.second->calibrate_with(queries);
+    }
+
+    /**
+     * @brief Space the snapshots every cell publishes after its moves, the ones created later included, see
+     * Partition::snapshot_every().
+     */
+    void snapshot_every(std::chrono::steady_clock::duration period)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _snapshotPeriod = period;
+
+        for (const auto &cell : _cells)
+            cell.second->snapshot_every(period);
+    }
+
+    /**
+     * @brief Move the objects of every loaded cell, one task per cell on the thread pool, then hand the objects that
+     * left their cell to the one they are now in.
+     */
+    void update_objects(float deltaTime)
+    {
+        std::vector<std::future<std::vector<SpatialObject>>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto &cell : _cells)
+            {
+                if (cell.second->isLoaded())
+                    tasks.emplace_back(_threadPool.enqueue(&Partition::update, cell.second, deltaTime));
+            }
+        }
+
+        std::vector<SpatialObject> leaving;
+        for (auto &task : tasks)
+        {
+            const std::vector<SpatialObject> left = task.get();
+            leaving.insert(leaving.end(), left.begin(), left.end());
+        }
+
+        if (!leaving.empty())
+            insert(leaving);
+    }
+
+    /**
+     * @brief The count loaded objects closest to point, nearest first, copied out of their cells.
+     *
+     * The cells are searched from the closest one, each with the distance of the worst object found so far as its
+     * limit. An object belongs to the cell its position is in but can stick out of it, so no cell is skipped on its
+     * bounds alone.
+     *
+     * @param filter objects for which filter(object) is false are skipped.
+     */
+    template <typename FILTER = OctreeAcceptAll>
+        requires std::predicate<FILTER &, const SpatialObject &>
+    [[nodiscard]] std::vector<OctreeNeighbour<SpatialObject>>
+    nearest(const glm::vec3 &point, size_t count, float maxDistance = std::numeric_limits<float>::infinity(),
+            FILTER &&filter = {}) const
+    {
+        std::vector<OctreeNeighbour<SpatialObject>> found;
+        std::vector<std::pair<float, std::shared_ptr<Partition>>> cells;
+
+        if (count == 0)
+            return found;
+
+        for (const auto &cell : *_cellList.load())
+        {
+            if (cell->isLoaded() || cell->isBaked())
+                cells.emplace_back(BoundaryBox(cell->getPosition(), cell->getSize()).squaredDistance(point), cell);
+        }
+
+        std::sort(cells.begin(), cells.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        const auto closer = [](const auto &a, const auto &b) { return a.distance2 < b.distance2; };
+
+        for (const auto &cell : cells)
         {
-            cell.second->draw(window, player_pos);
+            const float limit = found.size() == count ? std::sqrt(found.back().distance2) : maxDistance;
+            const std::vector<OctreeNeighbour<SpatialObject>> near = cell.second->nearest(point, count, limit, filter);
+            const size_t middle = found.size();
+
+            found.insert(found.end(), near.begin(), near.end());
+            std::inplace_merge(found.begin(), found.begin() + middle, found.end(), closer);
+            found.resize(std::min(found.size(), count));
+        }
+
+        return found;
+    }
+
+    /**
+     * @brief Shape and memory of the octrees of all the loaded cells together.
+     */
+    [[nodiscard]] OctreeStats stats() const
+    {
+        OctreeStats stats;
+
+        for (const auto &cell : *_cellList.load())
+        {
+            if (cell->isLoaded())
+                stats += cell->stats();
+        }
+
+        return stats;
+    }
+
+    void draw(sf::RenderWindow &window, const glm::vec3 &player_pos)
+    {
+        for (const auto &cell : *_cellList.load())
+        {
+            cell->draw(window, player_pos);
+        }
+    }
+
+    /**
+     * @brief Draw the objects of the loaded cells that are inside the view frustum of a camera.
+     */
+    void draw(sf::RenderWindow &window, const Frustum &frustum)
+    {
+        for (const auto &cell : *_cellList.load())
+        {
+            cell->draw(window, frustum);
         }
     }
 
@@ -236,9 +667,43 @@ public:
         _threadPool.enqueue(std::forward<Func>(func), std::forward<Args>(args)...);
     }
 
+private:
+    using CellList = std::vector<std::shared_ptr<Partition>>;
+
+    /**
+     * @brief The grid coordinates of the cell position is in.
+     */
+    [[nodiscard]] glm::ivec2 grid_of(const glm::vec3 &position) const noexcept
+    {
+        return {static_cast<int>(std::floor(position.x / _size.x)), static_cast<int>(std::floor(position.z / _size.z))};
+    }
+
+    /**
+     * @brief The cell at grid, created on first use. A new cell is published to the readers with a new cell list.
+     */
+    [[nodiscard]] const std::shared_ptr<Partition> &cell(glm::ivec2 grid)
+    {
+        auto [it, created] = _cells.try_emplace(grid);
+        if (!created)
+            return it->second;
+
+        it->second = std::make_shared<Partition>(glm::vec3(grid.x * _size.x, 0, grid.y * _size.z), _size);
+        if (_calibration)
+            it->second->calibrate_with(_calibration);
+        it->second->snapshot_every(_snapshotPeriod);
+
+        auto cellList = std::make_shared<CellList>(*_cellList.load());
+        cellList->emplace_back(it->second);
+        _cellList.store(std::move(cellList));
+        return it->second;
+    }
+
 private:
     glm::vec3 _size = {255, std::numeric_limits<float>::max(), 255};
     std::unordered_map<glm::ivec2, std::shared_ptr<Partition>> _cells;
+    std::function<void(const Partition::Container &)> _calibration; // handed to every new cell
+    std::chrono::steady_clock::duration _snapshotPeriod{};          // handed to every new cell as well
+    std::atomic<std::shared_ptr<const CellList>> _cellList{std::make_shared<const CellList>()}; // read without _mutex
     std::mutex _mutex;
     ThreadPool _threadPool;
 };
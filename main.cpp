@@ -82,6 +82,7 @@ int main()
 #ifndef RAYTRACING
         pos = glm::vec3({player_rect.getPosition().x, player_height, player_rect.getPosition().y});
         worldPartition.update(pos);
+        worldPartition.update_objects(deltaTime);
         worldPartition.draw(window, pos);
 #else
         const sf::Vector2f &pos = player_rect.getPosition();
@@ -21,6 +21,7 @@ target("optimizing")
     elseif is_mode("release") then
         add_defines("NDEBUG")
         set_optimize("fastest")
+        add_vectorexts("avx2")
     end
 
     add_files("./*.cpp")